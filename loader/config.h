@@ -2,6 +2,13 @@
 #define __CONFIG_H__
 
 // #define DEBUG
+// #define LAZY_BIND // also disables the prelink cache
+// #define LOADER_BENCHMARK 10
+// #define PROFILE
+// #define PROFILE_IMPORTS // also disables the prelink cache
+
+#define PROFILE_FLUSH_INTERVAL 10 // seconds
+#define SHADER_PREWARM_MB 32
 
 #define LOAD_ADDRESS 0x98000000
 
@@ -11,8 +18,17 @@
 
 #define DATA_PATH "ux0:data/conduit"
 #define SO_PATH DATA_PATH "/" "libTheConduit.so"
+#define APK_PATH DATA_PATH "/" "base.apk"
+#define APK_SO_ENTRY "lib/armeabi-v7a/libTheConduit.so"
+#define SO_CACHE_PATH DATA_PATH "/" "libTheConduit.cache"
+#define SO_RELR_PATH DATA_PATH "/" "libTheConduit.relr"
 #define OBB_PATH DATA_PATH "/" "main.obb"
 #define GLSL_PATH DATA_PATH "/" "glsl"
+#define SHADER_OVERLAY_PATH DATA_PATH "/" "shaders"
+#define LAZY_BIND_PATH DATA_PATH "/" "lazy_bind.txt"
+#define PROFILE_PATH DATA_PATH "/" "profile.txt"
+#define PROGRAM_CACHE_PATH DATA_PATH "/" "programs.bin"
+#define SHADER_MANIFEST_PATH DATA_PATH "/" "shader_manifest.txt"
 #define PSARC_PATH "app0:shaders.psarc"
 #define SHADERS_PATH "/shaders"
 
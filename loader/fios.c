@@ -13,6 +13,7 @@
 #include "main.h"
 #include "config.h"
 #include "fios.h"
+#include "psarc.h"
 #include "so_util.h"
 
 #define MAX_PATH_LENGTH 128
@@ -89,10 +90,17 @@ int fios_init(void) {
 	if (res < 0)
 		return res;
 
+	// Shaders are looked up by hash from now on, the mount stays as a fallback
+	if (psarc_index_load(PSARC_PATH) < 0)
+		debugPrintf("Error could not index %s\n", PSARC_PATH);
+	else
+		psarc_prewarm_start(SHADER_MANIFEST_PATH, SHADER_PREWARM_MB * 1024 * 1024);
+
 	return 0;
 }
 
 void fios_terminate(void) {
+	psarc_index_close();
 	sceFiosTerminate();
 	free(g_RamCacheWorkBuffer);
 }
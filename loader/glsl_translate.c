@@ -0,0 +1,695 @@
+/* glsl_translate.c -- GLSL ES shaders to Cg for libshacccg
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "glsl_translate.h"
+
+#define GLSL_MAX_PARAMS 32
+#define GLSL_MAX_DECLS 256
+#define GLSL_MAX_OPERANDS 16
+#define GLSL_MAX_TEXCOORDS 10
+
+// Same approach as the translator built into vitaGL: GLSL names are mapped to Cg through macros,
+// and the globals that Cg passes as arguments are moved into the signature of main
+static const char glsl_header[] =
+  "#define vec2 float2\n"
+  "#define vec3 float3\n"
+  "#define vec4 float4\n"
+  "#define ivec2 int2\n"
+  "#define ivec3 int3\n"
+  "#define ivec4 int4\n"
+  "#define bvec2 bool2\n"
+  "#define bvec3 bool3\n"
+  "#define bvec4 bool4\n"
+  "#define mat2 float2x2\n"
+  "#define mat3 float3x3\n"
+  "#define mat4 float4x4\n"
+  "#define texture2D tex2D\n"
+  "#define texture2DProj tex2Dproj\n"
+  "#define textureCube texCUBE\n"
+  "#define mix lerp\n"
+  "#define fract frac\n"
+  "#define inversesqrt rsqrt\n"
+  "#define dFdx ddx\n"
+  "#define dFdy ddy\n"
+  "#define mod(x, y) ((x) - (y) * floor((x) / (y)))\n"
+  "#define lowp\n"
+  "#define mediump\n"
+  "#define highp\n";
+
+enum {
+  TOKEN_SPACE, // whitespace, comments and preprocessor lines, copied as is
+  TOKEN_DROP,
+  TOKEN_IDENT,
+  TOKEN_NUMBER,
+  TOKEN_PUNCT,
+};
+
+typedef struct {
+  int type;
+  const char *str;
+  int len;
+} glsl_token;
+
+// What an expression evaluates to, as far as products are concerned
+enum {
+  KIND_UNKNOWN,
+  KIND_SCALAR,
+  KIND_VECTOR,
+  KIND_MATRIX,
+  KIND_ARRAY = 0x10, // set on arrays of the kind until they are indexed
+};
+
+typedef struct {
+  const glsl_token *type;
+  const glsl_token *name;
+} glsl_param;
+
+typedef struct {
+  const glsl_token *name;
+  int kind;
+} glsl_decl;
+
+// An operand of a chain of * and /, and the operator in front of it
+typedef struct {
+  int start, end;
+  int kind;
+  char op;
+} glsl_operand;
+
+typedef struct {
+  glsl_token *tokens;
+  int num_tokens;
+
+  glsl_param inputs[GLSL_MAX_PARAMS];
+  glsl_param varyings[GLSL_MAX_PARAMS];
+  glsl_decl decls[GLSL_MAX_DECLS];
+  int num_inputs, num_varyings, num_decls;
+  int fragment, point_size, frag_coord;
+
+  char *out;
+  int out_len, out_size;
+  int error;
+} glsl_translator;
+
+static int token_is(const glsl_token *t, const char *str) {
+  return t->len == strlen(str) && memcmp(t->str, str, t->len) == 0;
+}
+
+static int token_equal(const glsl_token *a, const glsl_token *b) {
+  return a->len == b->len && memcmp(a->str, b->str, a->len) == 0;
+}
+
+static int tokenize(glsl_translator *tr, const char *source, int length) {
+  const char *p = source, *end = source + length;
+  int max = 0, line_start = 1;
+
+  while (p < end) {
+    if (tr->num_tokens == max) {
+      max = max ? max * 2 : 1024;
+      glsl_token *tokens = realloc(tr->tokens, max * sizeof(glsl_token));
+      if (!tokens)
+        return -1;
+      tr->tokens = tokens;
+    }
+
+    glsl_token *t = &tr->tokens[tr->num_tokens++];
+    const char *start = p;
+
+    if (*p == '#' && line_start) {
+      while (p < end && *p != '\n')
+        p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+      // Cg doesn't know these, everything else is left to its preprocessor
+      int drop = (p - start >= 8 && memcmp(start, "#version", 8) == 0) ||
+                 (p - start >= 10 && memcmp(start, "#extension", 10) == 0);
+      t->type = drop ? TOKEN_DROP : TOKEN_SPACE;
+    } else if (isspace((unsigned char)*p)) {
+      while (p < end && isspace((unsigned char)*p)) {
+        if (*p == '\n')
+          line_start = 1;
+        p++;
+      }
+      t->type = TOKEN_SPACE;
+    } else if (*p == '/' && p + 1 < end && p[1] == '/') {
+      while (p < end && *p != '\n')
+        p++;
+      t->type = TOKEN_SPACE;
+    } else if (*p == '/' && p + 1 < end && p[1] == '*') {
+      p += 2;
+      while (p + 1 < end && !(p[0] == '*' && p[1] == '/'))
+        p++;
+      p = p + 2 < end ? p + 2 : end;
+      t->type = TOKEN_SPACE;
+    } else if (isalpha((unsigned char)*p) || *p == '_') {
+      while (p < end && (isalnum((unsigned char)*p) || *p == '_'))
+        p++;
+      t->type = TOKEN_IDENT;
+    } else if (isdigit((unsigned char)*p) || (*p == '.' && p + 1 < end && isdigit((unsigned char)p[1]))) {
+      while (p < end && (isalnum((unsigned char)*p) || *p == '.' ||
+                         ((*p == '+' || *p == '-') && (p[-1] == 'e' || p[-1] == 'E'))))
+        p++;
+      t->type = TOKEN_NUMBER;
+    } else {
+      p++;
+      t->type = TOKEN_PUNCT;
+    }
+
+    if (t->type != TOKEN_SPACE)
+      line_start = 0;
+
+    t->str = start;
+    t->len = p - start;
+  }
+
+  return 0;
+}
+
+static int next_token(glsl_translator *tr, int i, int end) {
+  while (i < end && (tr->tokens[i].type == TOKEN_SPACE || tr->tokens[i].type == TOKEN_DROP))
+    i++;
+  return i;
+}
+
+// float, vecN, matN and their int and bool variants, KIND_UNKNOWN for anything else
+static int type_kind(const glsl_token *t) {
+  const char *str = t->str;
+  int len = t->len;
+
+  if (token_is(t, "float") || token_is(t, "int") || token_is(t, "bool"))
+    return KIND_SCALAR;
+  if (len == 5 && (str[0] == 'i' || str[0] == 'b')) {
+    str++;
+    len--;
+  } else if (len == 4 && memcmp(str, "mat", 3) == 0 && str[3] >= '2' && str[3] <= '4') {
+    return KIND_MATRIX;
+  }
+  if (len == 4 && memcmp(str, "vec", 3) == 0 && str[3] >= '2' && str[3] <= '4')
+    return KIND_VECTOR;
+  return KIND_UNKNOWN;
+}
+
+// Shadowing is rare enough in game shaders that the first declaration of a name is used
+static int decl_kind(glsl_translator *tr, const glsl_token *t) {
+  for (int i = 0; i < tr->num_decls; i++) {
+    if (token_equal(tr->decls[i].name, t))
+      return tr->decls[i].kind;
+  }
+  return KIND_UNKNOWN;
+}
+
+static void add_decl(glsl_translator *tr, const glsl_token *name, int kind) {
+  if (tr->num_decls < GLSL_MAX_DECLS) {
+    tr->decls[tr->num_decls].name = name;
+    tr->decls[tr->num_decls].kind = kind;
+    tr->num_decls++;
+  }
+}
+
+// Index of the bracket closing the one at open, or end if there is none
+static int match(glsl_translator *tr, int open, int end) {
+  int depth = 0;
+
+  for (int i = open; i < end; i++) {
+    glsl_token *t = &tr->tokens[i];
+    if (t->type != TOKEN_PUNCT)
+      continue;
+    if (t->str[0] == '(' || t->str[0] == '[')
+      depth++;
+    else if ((t->str[0] == ')' || t->str[0] == ']') && --depth == 0)
+      return i;
+  }
+
+  return end;
+}
+
+// End of a declarator: the next comma, semicolon or body outside of brackets
+static int declarator_end(glsl_translator *tr, int i, int end) {
+  for (; i < end; i++) {
+    glsl_token *t = &tr->tokens[i];
+    if (t->type != TOKEN_PUNCT)
+      continue;
+    if (t->str[0] == '(' || t->str[0] == '[')
+      i = match(tr, i, end);
+    else if (strchr(",;{)", t->str[0]))
+      return i;
+  }
+  return end;
+}
+
+// Parses the type and the names of "attribute/varying [precision] type name, name;"
+static int collect_params(glsl_translator *tr, int start, int end, glsl_param *params, int *num) {
+  const glsl_token *type = NULL;
+
+  for (int i = next_token(tr, start, end); i < end; i = next_token(tr, i + 1, end)) {
+    glsl_token *t = &tr->tokens[i];
+    if (t->type != TOKEN_IDENT || token_is(t, "lowp") || token_is(t, "mediump") || token_is(t, "highp"))
+      continue;
+    if (!type) {
+      type = t;
+      continue;
+    }
+    if (*num == GLSL_MAX_PARAMS)
+      return -1;
+    params[*num].type = type;
+    params[*num].name = t;
+    (*num)++;
+    add_decl(tr, t, type_kind(type));
+  }
+
+  return 0;
+}
+
+// Finds the declarations that move into main, and the type of every declared name
+static int scan(glsl_translator *tr) {
+  int depth = 0;
+
+  for (int i = 0; i < tr->num_tokens; i++) {
+    glsl_token *t = &tr->tokens[i];
+
+    if (t->type == TOKEN_PUNCT && t->str[0] == '{')
+      depth++;
+    else if (t->type == TOKEN_PUNCT && t->str[0] == '}')
+      depth--;
+    if (t->type != TOKEN_IDENT)
+      continue;
+
+    if (token_is(t, "gl_PointSize"))
+      tr->point_size = 1;
+    else if (token_is(t, "gl_FragCoord"))
+      tr->frag_coord = 1;
+
+    if (depth == 0 && (token_is(t, "precision") || token_is(t, "attribute") || token_is(t, "varying"))) {
+      int end = i;
+      while (end < tr->num_tokens && !token_is(&tr->tokens[end], ";"))
+        end++;
+      if (end == tr->num_tokens)
+        return -1;
+
+      int res = 0;
+      if (token_is(t, "attribute"))
+        res = collect_params(tr, i + 1, end, tr->inputs, &tr->num_inputs);
+      else if (token_is(t, "varying"))
+        res = collect_params(tr, i + 1, end, tr->varyings, &tr->num_varyings);
+      if (res < 0)
+        return -1;
+
+      for (int j = i; j <= end; j++)
+        tr->tokens[j].type = TOKEN_DROP;
+      i = end;
+      continue;
+    }
+
+    // "type a = x, b" declares both, a function declares its return type
+    int kind = type_kind(t);
+    int j = next_token(tr, i + 1, tr->num_tokens);
+    while (kind && j < tr->num_tokens && tr->tokens[j].type == TOKEN_IDENT) {
+      int bracket = next_token(tr, j + 1, tr->num_tokens);
+      int array = bracket < tr->num_tokens && token_is(&tr->tokens[bracket], "[");
+      add_decl(tr, &tr->tokens[j], array ? kind | KIND_ARRAY : kind);
+      int k = declarator_end(tr, j + 1, tr->num_tokens);
+      if (k == tr->num_tokens || !token_is(&tr->tokens[k], ","))
+        break;
+      j = next_token(tr, k + 1, tr->num_tokens);
+    }
+  }
+
+  return 0;
+}
+
+static void append(glsl_translator *tr, const char *str, int len) {
+  if (tr->error)
+    return;
+
+  if (tr->out_len + len + 1 > tr->out_size) {
+    int size = tr->out_size ? tr->out_size * 2 : 4096;
+    while (size < tr->out_len + len + 1)
+      size *= 2;
+    char *out = realloc(tr->out, size);
+    if (!out) {
+      tr->error = 1;
+      return;
+    }
+    tr->out = out;
+    tr->out_size = size;
+  }
+
+  memcpy(tr->out + tr->out_len, str, len);
+  tr->out_len += len;
+  tr->out[tr->out_len] = '\0';
+}
+
+static void append_str(glsl_translator *tr, const char *str) {
+  append(tr, str, strlen(str));
+}
+
+static void append_token(glsl_translator *tr, const glsl_token *t) {
+  append(tr, t->str, t->len);
+}
+
+static int param_compare(const void *a, const void *b) {
+  const glsl_token *x = ((const glsl_param *)a)->name;
+  const glsl_token *y = ((const glsl_param *)b)->name;
+  int res = memcmp(x->str, y->str, x->len < y->len ? x->len : y->len);
+  return res ? res : x->len - y->len;
+}
+
+static void append_param(glsl_translator *tr, int *first, const char *param) {
+  if (!*first)
+    append_str(tr, ", ");
+  *first = 0;
+  append_str(tr, param);
+}
+
+static void append_signature(glsl_translator *tr) {
+  char semantic[32];
+  int first = 1;
+
+  for (int i = 0; i < tr->num_inputs; i++) {
+    append_param(tr, &first, "");
+    append_token(tr, tr->inputs[i].type);
+    append_str(tr, " ");
+    append_token(tr, tr->inputs[i].name);
+  }
+
+  // Both stages are compiled on their own, sorting by name hands out the same TEXCOORD on each side
+  for (int i = 0; i < tr->num_varyings; i++) {
+    append_param(tr, &first, tr->fragment ? "" : "out ");
+    append_token(tr, tr->varyings[i].type);
+    append_str(tr, " ");
+    append_token(tr, tr->varyings[i].name);
+    snprintf(semantic, sizeof(semantic), " : TEXCOORD%d", i);
+    append_str(tr, semantic);
+  }
+
+  if (tr->fragment) {
+    if (tr->frag_coord)
+      append_param(tr, &first, "float4 gl_FragCoord : WPOS");
+    append_param(tr, &first, "out float4 gl_FragColor : COLOR");
+  } else {
+    append_param(tr, &first, "out float4 gl_Position : POSITION");
+    if (tr->point_size)
+      append_param(tr, &first, "out float gl_PointSize : PSIZE");
+  }
+}
+
+static int is_keyword(const glsl_token *t) {
+  return token_is(t, "return") || token_is(t, "if") || token_is(t, "for") || token_is(t, "while");
+}
+
+static int is_swizzle(const glsl_token *t) {
+  if (t->len > 4)
+    return 0;
+  for (int i = 0; i < t->len; i++) {
+    if (!strchr("xyzwrgbastpq", t->str[i]))
+      return 0;
+  }
+  return 1;
+}
+
+static int parse_chain(glsl_translator *tr, int start, int end, glsl_operand *ops, int *num);
+static int chain_kind(const glsl_operand *ops, int num);
+
+// Parses a primary expression with its postfix operators, returns start if there is none. Unary
+// operators are only taken after a * or /, elsewhere they could be the binary ones.
+static int parse_operand(glsl_translator *tr, int start, int end, int unary, int *kind) {
+  glsl_token *t = &tr->tokens[start];
+  int i;
+
+  if (unary && t->type == TOKEN_PUNCT && strchr("+-!", t->str[0])) {
+    int next = next_token(tr, start + 1, end);
+    return next < end && (i = parse_operand(tr, next, end, 1, kind)) > next ? i : start;
+  }
+
+  if (t->type == TOKEN_NUMBER) {
+    *kind = KIND_SCALAR;
+    i = start + 1;
+  } else if (t->type == TOKEN_IDENT && !is_keyword(t)) {
+    int open = next_token(tr, start + 1, end);
+    if (open < end && token_is(&tr->tokens[open], "(")) {
+      // Constructors are typed by their name, functions by their declaration
+      *kind = type_kind(t) ? type_kind(t) : decl_kind(tr, t);
+      i = match(tr, open, end) + 1;
+    } else {
+      *kind = decl_kind(tr, t);
+      i = start + 1;
+    }
+  } else if (token_is(t, "(")) {
+    glsl_operand ops[GLSL_MAX_OPERANDS];
+    int num, close = match(tr, start, end);
+    int inner = next_token(tr, start + 1, close);
+    int stop = inner < close ? next_token(tr, parse_chain(tr, inner, close, ops, &num), close) : inner;
+    *kind = inner < close && stop == close ? chain_kind(ops, num) : KIND_UNKNOWN;
+    i = close + 1;
+  } else {
+    return start;
+  }
+
+  if (i > end)
+    return end;
+
+  while (1) {
+    int next = next_token(tr, i, end);
+    if (next < end && token_is(&tr->tokens[next], "[")) {
+      if (*kind & KIND_ARRAY)
+        *kind &= ~KIND_ARRAY;
+      else
+        *kind = *kind == KIND_MATRIX ? KIND_VECTOR : *kind == KIND_VECTOR ? KIND_SCALAR : KIND_UNKNOWN;
+      i = match(tr, next, end) + 1;
+      if (i > end)
+        return end;
+    } else if (next + 1 < end && token_is(&tr->tokens[next], ".") && tr->tokens[next + 1].type == TOKEN_IDENT) {
+      const glsl_token *field = &tr->tokens[next + 1];
+      *kind = !is_swizzle(field) ? KIND_UNKNOWN : field->len == 1 ? KIND_SCALAR : KIND_VECTOR;
+      i = next + 2;
+    } else {
+      return i;
+    }
+  }
+}
+
+// Parses "a * b / c ..." from start, which must be an operand. Returns the end of the last operand.
+static int parse_chain(glsl_translator *tr, int start, int end, glsl_operand *ops, int *num) {
+  int i = parse_operand(tr, start, end, 0, &ops[0].kind);
+  ops[0].start = start;
+  ops[0].end = i;
+  ops[0].op = 0;
+  *num = 1;
+
+  while (*num < GLSL_MAX_OPERANDS) {
+    int op = next_token(tr, i, end);
+    if (op + 1 >= end || !(token_is(&tr->tokens[op], "*") || token_is(&tr->tokens[op], "/")) ||
+        token_is(&tr->tokens[op + 1], "="))
+      break;
+
+    glsl_operand *operand = &ops[*num];
+    operand->start = next_token(tr, op + 1, end);
+    if (operand->start == end)
+      break;
+    operand->end = parse_operand(tr, operand->start, end, 1, &operand->kind);
+    if (operand->end == operand->start)
+      break;
+    operand->op = tr->tokens[op].str[0];
+    i = operand->end;
+    (*num)++;
+  }
+
+  return i;
+}
+
+// A matrix times anything but a scalar is a mul(), everything else is component-wise
+static int is_product(int op, int a, int b) {
+  return op == '*' && (a == KIND_MATRIX || b == KIND_MATRIX) && a != KIND_SCALAR && b != KIND_SCALAR;
+}
+
+static int product_kind(int op, int a, int b) {
+  if (is_product(op, a, b))
+    return a == KIND_MATRIX && b == KIND_MATRIX ? KIND_MATRIX : KIND_VECTOR;
+  if (a == KIND_MATRIX || b == KIND_MATRIX)
+    return KIND_MATRIX;
+  if (a == KIND_VECTOR || b == KIND_VECTOR)
+    return KIND_VECTOR;
+  return a == KIND_SCALAR && b == KIND_SCALAR ? KIND_SCALAR : KIND_UNKNOWN;
+}
+
+static int chain_kind(const glsl_operand *ops, int num) {
+  int kind = ops[0].kind;
+  for (int i = 1; i < num; i++)
+    kind = product_kind(ops[i].op, kind, ops[i].kind);
+  return kind;
+}
+
+static void emit(glsl_translator *tr, int start, int end);
+
+// Copies an operand, translating what is inside of its brackets
+static void emit_operand(glsl_translator *tr, int start, int end) {
+  for (int i = start; i < end; i++) {
+    glsl_token *t = &tr->tokens[i];
+
+    if (t->type == TOKEN_DROP)
+      continue;
+
+    // Cg narrows a matrix with a cast, its constructors only take scalars and vectors
+    if (t->type == TOKEN_IDENT && type_kind(t) == KIND_MATRIX) {
+      glsl_operand ops[GLSL_MAX_OPERANDS];
+      int num, kind, open = next_token(tr, i + 1, end);
+      int close = open < end && token_is(&tr->tokens[open], "(") ? match(tr, open, end) : end;
+      int inner = close < end ? next_token(tr, open + 1, close) : close;
+      if (inner < close && parse_operand(tr, inner, close, 0, &kind) > inner &&
+          next_token(tr, parse_chain(tr, inner, close, ops, &num), close) == close &&
+          chain_kind(ops, num) == KIND_MATRIX) {
+        append_str(tr, "((");
+        append_token(tr, t);
+        append_str(tr, ")");
+        emit_operand(tr, open, close + 1);
+        append_str(tr, ")");
+        i = close;
+        continue;
+      }
+    }
+
+    append_token(tr, t);
+    if (t->type == TOKEN_PUNCT && (t->str[0] == '(' || t->str[0] == '[')) {
+      int close = match(tr, i, end);
+      emit(tr, i + 1, close);
+      if (close < end)
+        append_token(tr, &tr->tokens[close]);
+      i = close;
+    }
+  }
+}
+
+// Translates an operand into a string of its own, since mul() swaps the operands around
+static char *operand_string(glsl_translator *tr, int start, int end) {
+  int len = tr->out_len;
+  emit_operand(tr, start, end);
+  if (tr->error)
+    return NULL;
+
+  char *str = malloc(tr->out_len - len + 1);
+  if (str) {
+    memcpy(str, tr->out + len, tr->out_len - len);
+    str[tr->out_len - len] = '\0';
+  } else {
+    tr->error = 1;
+  }
+  tr->out_len = len;
+  return str;
+}
+
+// GLSL multiplies matrices with *, Cg with mul(). GL uploads column-major, which Cg reads as the
+// transpose, so A * B becomes mul(B, A) for M * v, v * M and M * M alike.
+static int emit_chain(glsl_translator *tr, int start, int end) {
+  glsl_operand ops[GLSL_MAX_OPERANDS];
+  int num, stop = parse_chain(tr, start, end, ops, &num);
+
+  int products = 0;
+  for (int i = 1, kind = ops[0].kind; i < num; i++) {
+    products |= is_product(ops[i].op, kind, ops[i].kind);
+    kind = product_kind(ops[i].op, kind, ops[i].kind);
+  }
+
+  if (!products) {
+    emit_operand(tr, ops[0].start, ops[0].end);
+    for (int i = 1; i < num; i++) {
+      for (int j = ops[i - 1].end; j < ops[i].start; j++)
+        append_token(tr, &tr->tokens[j]);
+      emit_operand(tr, ops[i].start, ops[i].end);
+    }
+    return stop;
+  }
+
+  char *acc = operand_string(tr, ops[0].start, ops[0].end);
+  int kind = ops[0].kind;
+
+  for (int i = 1; i < num && acc; i++) {
+    char *operand = operand_string(tr, ops[i].start, ops[i].end);
+    if (!operand)
+      break;
+
+    int size = strlen(acc) + strlen(operand) + 8;
+    char *res = malloc(size);
+    if (res && is_product(ops[i].op, kind, ops[i].kind))
+      snprintf(res, size, "mul(%s, %s)", operand, acc);
+    else if (res)
+      snprintf(res, size, "%s %c %s", acc, ops[i].op, operand);
+    kind = product_kind(ops[i].op, kind, ops[i].kind);
+
+    free(operand);
+    free(acc);
+    acc = res;
+  }
+
+  if (acc)
+    append_str(tr, acc);
+  else
+    tr->error = 1;
+  free(acc);
+  return stop;
+}
+
+static void emit(glsl_translator *tr, int start, int end) {
+  for (int i = start; i < end; i++) {
+    glsl_token *t = &tr->tokens[i];
+
+    if (t->type == TOKEN_DROP)
+      continue;
+
+    if (t->type == TOKEN_IDENT && token_is(t, "main")) {
+      int open = next_token(tr, i + 1, end);
+      if (open < end && token_is(&tr->tokens[open], "(")) {
+        int close = open;
+        while (close < end && !token_is(&tr->tokens[close], ")"))
+          close++;
+        append_str(tr, "main(");
+        append_signature(tr);
+        append_str(tr, ")");
+        i = close;
+        continue;
+      }
+    }
+
+    int kind;
+    if (parse_operand(tr, i, end, 0, &kind) > i) {
+      i = emit_chain(tr, i, end) - 1;
+      continue;
+    }
+
+    append_token(tr, t);
+  }
+}
+
+// Returns the Cg source, which the caller frees with free(), or NULL if the shader can't be translated
+char *glsl_translate(const char *source, int length, int fragment, int *out_length) {
+  glsl_translator tr;
+
+  memset(&tr, 0, sizeof(glsl_translator));
+  tr.fragment = fragment;
+
+  if (tokenize(&tr, source, length) < 0 || scan(&tr) < 0 || tr.num_varyings > GLSL_MAX_TEXCOORDS) {
+    free(tr.tokens);
+    return NULL;
+  }
+
+  qsort(tr.varyings, tr.num_varyings, sizeof(glsl_param), param_compare);
+
+  append_str(&tr, glsl_header);
+  emit(&tr, 0, tr.num_tokens);
+  free(tr.tokens);
+
+  if (tr.error) {
+    free(tr.out);
+    return NULL;
+  }
+
+  *out_length = tr.out_len;
+  return tr.out;
+}
@@ -0,0 +1,6 @@
+#ifndef __GLSL_TRANSLATE_H__
+#define __GLSL_TRANSLATE_H__
+
+char *glsl_translate(const char *source, int length, int fragment, int *out_length);
+
+#endif
@@ -0,0 +1,10 @@
+// Generated by tools/gen_hook_offsets.py without a library, do not edit
+
+#include <stddef.h>
+
+#include "hook_offsets.h"
+
+const so_hook_offsets game_hooks_offsets = { NULL, NULL, 0 };
+const so_hook_offsets movie_hooks_offsets = { NULL, NULL, 0 };
+const so_hook_offsets mpg123_hooks_offsets = { NULL, NULL, 0 };
+const so_hook_offsets openal_hooks_offsets = { NULL, NULL, 0 };
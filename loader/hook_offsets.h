@@ -0,0 +1,13 @@
+// Generated by tools/gen_hook_offsets.py, do not edit
+
+#ifndef __HOOK_OFFSETS_H__
+#define __HOOK_OFFSETS_H__
+
+#include "so_util.h"
+
+extern const so_hook_offsets game_hooks_offsets;
+extern const so_hook_offsets movie_hooks_offsets;
+extern const so_hook_offsets mpg123_hooks_offsets;
+extern const so_hook_offsets openal_hooks_offsets;
+
+#endif
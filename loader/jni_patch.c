@@ -149,6 +149,7 @@ int InitEGLAndGLES2(void) {
 }
 
 int swapBuffers(void) {
+  shader_swap_ready();
   movie_draw_frame();
   vglSwapBuffers(GL_FALSE);
   return 1;
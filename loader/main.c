@@ -31,11 +31,17 @@
 #include "dialog.h"
 #include "fios.h"
 #include "so_util.h"
+#include "hook_offsets.h"
 #include "jni_patch.h"
 #include "movie_patch.h"
 #include "mpg123_patch.h"
 #include "openal_patch.h"
+#include "profile.h"
+#include "program_cache.h"
+#include "psarc.h"
 #include "sha1.h"
+#include "shader_compiler.h"
+#include "xxhash.h"
 
 #include "libc_bridge.h"
 
@@ -264,99 +270,258 @@ int ProcessEvents(void) {
 extern void *__cxa_guard_acquire;
 extern void *__cxa_guard_release;
 
+static so_hook game_hooks[] = {
+  { "__cxa_guard_acquire", (uintptr_t)&__cxa_guard_acquire },
+  { "__cxa_guard_release", (uintptr_t)&__cxa_guard_release },
+
+  { "_Z24NVThreadGetCurrentJNIEnvv", (uintptr_t)NVThreadGetCurrentJNIEnv },
+
+  { "_ZN10TouchSense8instanceEv", (uintptr_t)ret0 },
+  { "_Z14ass_CueHapticsP6CStratPK6ASLVar", (uintptr_t)ret0 },
+
+  { "_Z15OS_ThreadLaunchPFjPvES_jPKci16OSThreadPriority", (uintptr_t)OS_ThreadLaunch },
+  { "_Z13OS_ThreadWaitPv", (uintptr_t)OS_ThreadWait },
+  { "OSResumeThread", (uintptr_t)ret0 },
+
+  { "OSSetThreadSpecific", (uintptr_t)ret0 },
+  { "OSGetThreadSpecific", (uintptr_t)OSGetThreadSpecific },
+  { "OSGetCurrentThread", (uintptr_t)OSGetCurrentThread },
+
+  { "_Z13ProcessEventsb", (uintptr_t)ProcessEvents },
+
+  { "_Z20AND_SystemInitializev", (uintptr_t)ret0 },
+
+  { "_Z14AND_FileUpdated", (uintptr_t)ret0 },
+  { "_Z17AND_BillingUpdateb", (uintptr_t)ret0 },
+
+  { "_Z21OS_BillingIsPurchasedPKc", (uintptr_t)ret1 },
+
+  { "_Z13OS_SystemChipv", (uintptr_t)OS_SystemChip },
+
+  { "_Z17OS_ScreenGetWidthv", (uintptr_t)OS_ScreenGetWidth },
+  { "_Z18OS_ScreenGetHeightv", (uintptr_t)OS_ScreenGetHeight },
+
+  { "_Z9NvAPKOpenPKc", (uintptr_t)ret0 },
+
+  { "_Z21ass_GetNumScreenshotsP6CStratP6ASLVarPKS1_", (uintptr_t)ret0 },
+  { "_Z17ass_GetScreenshotP6CStratP6ASLVarPKS1_", (uintptr_t)ret0 },
+  { "_Z21ass_ScreenshotCaptureP6CStratPK6ASLVar", (uintptr_t)ret0 },
+  { "_Z22ass_ScreenshotClearAllP6CStratPK6ASLVar", (uintptr_t)ret0 },
+
+  { "_Z12ass_RateGameP6CStratPK6ASLVar", (uintptr_t)ret0 },
+};
+
 void patch_game(void) {
   IsInitGraphics = (char *)so_symbol(&conduit_mod, "IsInitGraphics");
   initGraphics = (void *)so_symbol(&conduit_mod, "_Z12initGraphicsv");
 
   *(int *)so_symbol(&conduit_mod, "IsAndroidPaused") = 0;
 
-  hook_addr(so_symbol(&conduit_mod, "__cxa_guard_acquire"), (uintptr_t)&__cxa_guard_acquire);
-  hook_addr(so_symbol(&conduit_mod, "__cxa_guard_release"), (uintptr_t)&__cxa_guard_release);
-
-  hook_addr(so_symbol(&conduit_mod, "_Z24NVThreadGetCurrentJNIEnvv"), (uintptr_t)NVThreadGetCurrentJNIEnv);
-
-  hook_addr(so_symbol(&conduit_mod, "_ZN10TouchSense8instanceEv"), (uintptr_t)ret0);
-  hook_addr(so_symbol(&conduit_mod, "_Z14ass_CueHapticsP6CStratPK6ASLVar"), (uintptr_t)ret0);
+  so_hook_table(&conduit_mod, game_hooks, sizeof(game_hooks), &game_hooks_offsets);
+}
 
-  hook_addr(so_symbol(&conduit_mod, "_Z15OS_ThreadLaunchPFjPvES_jPKci16OSThreadPriority"), (uintptr_t)OS_ThreadLaunch);
-  hook_addr(so_symbol(&conduit_mod, "_Z13OS_ThreadWaitPv"), (uintptr_t)OS_ThreadWait);
-  hook_addr(so_symbol(&conduit_mod, "OSResumeThread"), (uintptr_t)ret0);
+#ifdef PROFILE
+// Functions replaced by game_hooks can't be instrumented, their prologue is gone
+static char *profile_symbols[] = {
+  "_Z12initGraphicsv",
 
-  hook_addr(so_symbol(&conduit_mod, "OSSetThreadSpecific"), (uintptr_t)ret0);
-  hook_addr(so_symbol(&conduit_mod, "OSGetThreadSpecific"), (uintptr_t)OSGetThreadSpecific);
-  hook_addr(so_symbol(&conduit_mod, "OSGetCurrentThread"), (uintptr_t)OSGetCurrentThread);
+  "_Z11OS_FileOpen14OSFileDataAreaPPvPKc16OSFileAccessType",
+  "_Z11OS_FileReadPvS_i",
+  "_Z18OS_FileSetPositionPvi",
+  "_Z11OS_FileSizePv",
+  "_Z12OS_FileClosePv",
+};
+#endif
 
-  hook_addr(so_symbol(&conduit_mod, "_Z13ProcessEventsb"), (uintptr_t)ProcessEvents);
+static void *shader_read_file(const char *path, int *size) {
+  static char *buf = NULL;
+  static int buf_size = 0;
 
-  hook_addr(so_symbol(&conduit_mod, "_Z20AND_SystemInitializev"), (uintptr_t)ret0);
+  FILE *file = sceLibcBridge_fopen(path, "rb");
+  if (!file)
+    return NULL;
 
-  hook_addr(so_symbol(&conduit_mod, "_Z14AND_FileUpdated"), (uintptr_t)ret0);
-  hook_addr(so_symbol(&conduit_mod, "_Z17AND_BillingUpdateb"), (uintptr_t)ret0);
+  sceLibcBridge_fseek(file, 0, SEEK_END);
+  *size = sceLibcBridge_ftell(file);
+  sceLibcBridge_fseek(file, 0, SEEK_SET);
 
-  hook_addr(so_symbol(&conduit_mod, "_Z21OS_BillingIsPurchasedPKc"), (uintptr_t)ret1);
+  if (*size > buf_size) {
+    free(buf);
+    buf = malloc(*size);
+    buf_size = buf ? *size : 0;
+  }
 
-  hook_addr(so_symbol(&conduit_mod, "_Z13OS_SystemChipv"), (uintptr_t)OS_SystemChip);
+  if (buf)
+    sceLibcBridge_fread(buf, 1, *size, file);
+  sceLibcBridge_fclose(file);
 
-  hook_addr(so_symbol(&conduit_mod, "_Z17OS_ScreenGetWidthv"), (uintptr_t)OS_ScreenGetWidth);
-  hook_addr(so_symbol(&conduit_mod, "_Z18OS_ScreenGetHeightv"), (uintptr_t)OS_ScreenGetHeight);
+  return buf;
+}
 
-  hook_addr(so_symbol(&conduit_mod, "_Z9NvAPKOpenPKc"), (uintptr_t)ret0);
+// Shaders are keyed by the XXH64 of their source and its length. Archives from older versions
+// name them after the first SHA1 word of the source instead, those and the dummies have a length of 0.
+#define SHADER_DUMMY_FRAGMENT 0xbf999cdf
+#define SHADER_DUMMY_VERTEX 0x0539a408
 
-  hook_addr(so_symbol(&conduit_mod, "_Z21ass_GetNumScreenshotsP6CStratP6ASLVarPKS1_"), (uintptr_t)ret0);
-  hook_addr(so_symbol(&conduit_mod, "_Z17ass_GetScreenshotP6CStratP6ASLVarPKS1_"), (uintptr_t)ret0);
-  hook_addr(so_symbol(&conduit_mod, "_Z21ass_ScreenshotCaptureP6CStratPK6ASLVar"), (uintptr_t)ret0);
-  hook_addr(so_symbol(&conduit_mod, "_Z22ass_ScreenshotClearAllP6CStratPK6ASLVar"), (uintptr_t)ret0);
+// Uses the PSARC index when it is available, so that a missing shader costs no filesystem access
+static void *shader_read(uint64_t hash, uint32_t length, int *size) {
+  if (psarc_index_loaded())
+    return psarc_index_read(hash, length, size);
 
-  hook_addr(so_symbol(&conduit_mod, "_Z12ass_RateGameP6CStratPK6ASLVar"), (uintptr_t)ret0);
+  char cg_path[1024];
+  if (length)
+    snprintf(cg_path, sizeof(cg_path), "%s/%016llx_%08x.cg.gxp", SHADERS_PATH, hash, length);
+  else
+    snprintf(cg_path, sizeof(cg_path), "%s/%08x.cg.gxp", SHADERS_PATH, (uint32_t)hash);
+  return shader_read_file(cg_path, size);
 }
 
-void glShaderSourceHook(GLuint shader, GLsizei count, const GLchar **string, const GLint *length) {
+static uint32_t shader_legacy_hash(const GLchar *string, GLint length) {
   uint32_t sha1[5];
   SHA1_CTX ctx;
 
   sha1_init(&ctx);
-  sha1_update(&ctx, (uint8_t *)*string, *length);
+  sha1_update(&ctx, (uint8_t *)string, length);
   sha1_final(&ctx, (uint8_t *)sha1);
 
-  char glsl_path[1024];
-  snprintf(glsl_path, sizeof(glsl_path), "%s/%08x.glsl", GLSL_PATH, sha1[0]);
+  return sha1[0];
+}
+
+// Shaders that are still using the dummy, swapped for the compiled one by shader_swap_ready
+#define SHADER_PENDING_MAX 256
 
-  char cg_path[1024];
-  snprintf(cg_path, sizeof(cg_path), "%s/%08x.cg.gxp", SHADERS_PATH, sha1[0]);
+typedef struct {
+  GLuint shader;
+  uint64_t hash;
+  uint32_t length;
+  int ready; // reported by the compiler, kept until the GXP could be read
+} shader_pending;
+
+static shader_pending pending_shaders[SHADER_PENDING_MAX];
+static int num_pending_shaders = 0;
+
+static void shader_pending_remove(GLuint shader) {
+  for (int i = 0; i < num_pending_shaders; i++) {
+    if (pending_shaders[i].shader == shader) {
+      pending_shaders[i] = pending_shaders[--num_pending_shaders];
+      return;
+    }
+  }
+}
+
+// Called between frames, so that programs don't change in the middle of one. A GXP that can't be
+// read yet is tried again on the next frame.
+void shader_swap_ready(void) {
+  uint64_t hash;
+  uint32_t length;
+
+  while (shader_compiler_ready(&hash, &length)) {
+    for (int i = 0; i < num_pending_shaders; i++) {
+      if (pending_shaders[i].hash == hash && pending_shaders[i].length == length)
+        pending_shaders[i].ready = 1;
+    }
+  }
 
-  FILE *file;
+  for (int i = 0; i < num_pending_shaders; i++) {
+    shader_pending *pending = &pending_shaders[i];
+    if (!pending->ready)
+      continue;
 
-  file = sceLibcBridge_fopen(cg_path, "rb");
-  if (!file) {
-    file = sceLibcBridge_fopen(glsl_path, "w");
+    int size;
+    void *buf = shader_compiler_lookup(pending->hash, pending->length, &size);
+    if (!buf)
+      continue;
+
+    GLuint shader = pending->shader;
+    hash = pending->hash;
+    length = pending->length;
+    pending_shaders[i--] = pending_shaders[--num_pending_shaders];
+
+    glShaderBinary(1, &shader, 0, buf, size);
+    program_cache_shader(shader, hash, length);
+    program_cache_relink(shader);
+  }
+}
+
+void glShaderSourceHook(GLuint shader, GLsizei count, const GLchar **string, const GLint *length) {
+  uint64_t hash = xxh64(*string, *length, 0);
+  uint32_t key_length = *length;
+
+  shader_pending_remove(shader);
+
+  // Shaders compiled on the device take precedence, they only exist for sources missing from the archive
+  int size;
+  void *buf = shader_compiler_lookup(hash, *length, &size);
+  if (!buf)
+    buf = shader_read(hash, *length, &size);
+  if (!buf) {
+    // Only archives that haven't been migrated pay for the SHA1
+    uint32_t legacy = shader_legacy_hash(*string, *length);
+    buf = shader_read(legacy, 0, &size);
+    if (buf) {
+      hash = legacy;
+      key_length = 0;
+    }
+  }
+
+  if (buf) {
+    program_cache_shader(shader, hash, key_length);
+  } else {
+    int fragment = strstr(*string, "gl_FragColor") != NULL;
+
+    char glsl_path[1024];
+    snprintf(glsl_path, sizeof(glsl_path), "%s/%016llx_%08x.glsl", GLSL_PATH, hash, *length);
+
+    FILE *file = sceLibcBridge_fopen(glsl_path, "w");
     if (file) {
       sceLibcBridge_fwrite(*string, 1, *length, file);
       sceLibcBridge_fclose(file);
     }
 
-    if (strstr(*string, "gl_FragColor"))
-      snprintf(cg_path, sizeof(cg_path), "%s/bf999cdf.cg.gxp", SHADERS_PATH);
-    else
-      snprintf(cg_path, sizeof(cg_path), "%s/0539a408.cg.gxp", SHADERS_PATH);
+    // The dummy stands in until the compiled shader is in the overlay
+    shader_compiler_queue(hash, *length, *string, fragment);
+
+    // Programs are cached by the shader that was actually used
+    uint64_t dummy = fragment ? SHADER_DUMMY_FRAGMENT : SHADER_DUMMY_VERTEX;
+    buf = shader_read(dummy, 0, &size);
+    program_cache_shader(shader, dummy, 0);
+    program_cache_dummy(shader);
 
-    file = sceLibcBridge_fopen(cg_path, "rb");
-    if (!file)
+    if (!buf) {
       debugPrintf("Error loading dummy shader\n");
-  } else {
-    // printf("Using %s\n", cg_path);
+      return;
+    }
+
+    if (num_pending_shaders < SHADER_PENDING_MAX) {
+      pending_shaders[num_pending_shaders].shader = shader;
+      pending_shaders[num_pending_shaders].hash = hash;
+      pending_shaders[num_pending_shaders].length = *length;
+      pending_shaders[num_pending_shaders].ready = 0;
+      num_pending_shaders++;
+    }
   }
 
-  sceLibcBridge_fseek(file, 0, SEEK_END);
-  int size = sceLibcBridge_ftell(file);
-  sceLibcBridge_fseek(file, 0, SEEK_SET);
+  glShaderBinary(1, &shader, 0, buf, size);
+}
 
-  char *buf = malloc(size);
-  sceLibcBridge_fread(buf, 1, size, file);
-  sceLibcBridge_fclose(file);
+void glAttachShaderHook(GLuint program, GLuint shader) {
+  glAttachShader(program, shader);
+  program_cache_attach(program, shader);
+}
 
-  glShaderBinary(1, &shader, 0, buf, size);
+void glBindAttribLocationHook(GLuint program, GLuint index, const GLchar *name) {
+  glBindAttribLocation(program, index, name);
+  program_cache_bind_attrib(program, index, name);
+}
+
+void glDeleteProgramHook(GLuint program) {
+  program_cache_forget(program);
+  glDeleteProgram(program);
+}
 
-  free(buf);
+void glDeleteShaderHook(GLuint shader) {
+  shader_pending_remove(shader);
+  glDeleteShader(shader);
 }
 
 void glCompileShaderHook(GLuint shader) {
@@ -439,8 +604,8 @@ static so_default_dynlib default_dynlib[] = {
   // { "gettid", (uintptr_t)&gettid },
   { "gettimeofday", (uintptr_t)&gettimeofday },
   { "glActiveTexture", (uintptr_t)&glActiveTexture },
-  { "glAttachShader", (uintptr_t)&glAttachShader },
-  { "glBindAttribLocation", (uintptr_t)&glBindAttribLocation },
+  { "glAttachShader", (uintptr_t)&glAttachShaderHook },
+  { "glBindAttribLocation", (uintptr_t)&glBindAttribLocationHook },
   { "glBindBuffer", (uintptr_t)&glBindBuffer },
   { "glBindFramebuffer", (uintptr_t)&glBindFramebuffer },
   { "glBindRenderbuffer", (uintptr_t)&ret0 },
@@ -459,9 +624,9 @@ static so_default_dynlib default_dynlib[] = {
   { "glCullFace", (uintptr_t)&glCullFace },
   { "glDeleteBuffers", (uintptr_t)&glDeleteBuffers },
   { "glDeleteFramebuffers", (uintptr_t)&glDeleteFramebuffers },
-  { "glDeleteProgram", (uintptr_t)&glDeleteProgram },
+  { "glDeleteProgram", (uintptr_t)&glDeleteProgramHook },
   { "glDeleteRenderbuffers", (uintptr_t)&ret0 },
-  { "glDeleteShader", (uintptr_t)&glDeleteShader },
+  { "glDeleteShader", (uintptr_t)&glDeleteShaderHook },
   { "glDeleteTextures", (uintptr_t)&glDeleteTextures },
   { "glDepthFunc", (uintptr_t)&glDepthFunc },
   { "glDepthMask", (uintptr_t)&glDepthMask },
@@ -487,27 +652,27 @@ static so_default_dynlib default_dynlib[] = {
   { "glGetShaderInfoLog", (uintptr_t)&glGetShaderInfoLog },
   { "glGetShaderiv", (uintptr_t)&glGetShaderiv },
   { "glGetString", (uintptr_t)&glGetString },
-  { "glGetUniformLocation", (uintptr_t)&glGetUniformLocation },
+  { "glGetUniformLocation", (uintptr_t)&program_cache_uniform_location },
   { "glGetVertexAttribPointerv", (uintptr_t)&glGetVertexAttribPointerv },
   { "glGetVertexAttribiv", (uintptr_t)&glGetVertexAttribiv },
-  { "glLinkProgram", (uintptr_t)&glLinkProgram },
+  { "glLinkProgram", (uintptr_t)&program_cache_link },
   { "glReadPixels", (uintptr_t)&glReadPixels },
   { "glRenderbufferStorage", (uintptr_t)&ret0 },
   { "glShaderSource", (uintptr_t)&glShaderSourceHook },
   { "glTexImage2D", (uintptr_t)&glTexImage2D },
   { "glTexParameterf", (uintptr_t)&glTexParameterf },
   { "glTexParameteri", (uintptr_t)&glTexParameteri },
-  { "glUniform1f", (uintptr_t)&glUniform1f },
-  { "glUniform1i", (uintptr_t)&glUniform1i },
-  { "glUniform2f", (uintptr_t)&glUniform2f },
-  { "glUniform3f", (uintptr_t)&glUniform3f },
-  { "glUniform3fv", (uintptr_t)&glUniform3fv },
-  { "glUniform4f", (uintptr_t)&glUniform4f },
-  { "glUniform4fv", (uintptr_t)&glUniform4fv },
-  { "glUniformMatrix2fv", (uintptr_t)&glUniformMatrix2fv },
-  { "glUniformMatrix3fv", (uintptr_t)&glUniformMatrix3fv },
-  { "glUniformMatrix4fv", (uintptr_t)&glUniformMatrix4fv },
-  { "glUseProgram", (uintptr_t)&glUseProgram },
+  { "glUniform1f", (uintptr_t)&program_cache_uniform1f },
+  { "glUniform1i", (uintptr_t)&program_cache_uniform1i },
+  { "glUniform2f", (uintptr_t)&program_cache_uniform2f },
+  { "glUniform3f", (uintptr_t)&program_cache_uniform3f },
+  { "glUniform3fv", (uintptr_t)&program_cache_uniform3fv },
+  { "glUniform4f", (uintptr_t)&program_cache_uniform4f },
+  { "glUniform4fv", (uintptr_t)&program_cache_uniform4fv },
+  { "glUniformMatrix2fv", (uintptr_t)&program_cache_uniform_matrix2fv },
+  { "glUniformMatrix3fv", (uintptr_t)&program_cache_uniform_matrix3fv },
+  { "glUniformMatrix4fv", (uintptr_t)&program_cache_uniform_matrix4fv },
+  { "glUseProgram", (uintptr_t)&program_cache_use },
   { "glVertexAttribPointer", (uintptr_t)&glVertexAttribPointer },
   { "glViewport", (uintptr_t)&glViewport },
   // { "gzclose", (uintptr_t)&gzclose },
@@ -609,6 +774,49 @@ static so_default_dynlib default_dynlib[] = {
   { "write", (uintptr_t)&write },
 };
 
+#ifdef LAZY_BIND
+static void lazy_bind_report(void) {
+  so_lazy_report(&conduit_mod, LAZY_BIND_PATH);
+}
+#endif
+
+static SceUInt64 patch_time;
+
+// Runs once the image is linked, hooks land in staged text pages and are flushed together with them
+static void patch_conduit(so_module *mod) {
+  SceUInt64 t_start = sceKernelGetProcessTimeWide();
+
+  patch_mpg123();
+  patch_openal();
+  patch_game();
+  patch_movie();
+
+#ifdef PROFILE
+  profile_hook(mod, profile_symbols, sizeof(profile_symbols));
+#endif
+
+  patch_time = sceKernelGetProcessTimeWide() - t_start;
+}
+
+// The boot pipeline, so_reload replays it as is
+static const so_pipeline conduit_pipeline = {
+  .relr_path = SO_RELR_PATH,
+  .cache_path = SO_CACHE_PATH,
+#ifdef LAZY_BIND
+  .lazy_bind = 1,
+#endif
+#ifdef PROFILE_IMPORTS
+  .import_hook = profile_import,
+#endif
+  .patch = patch_conduit,
+};
+
+#if defined(PROFILE) || defined(PROFILE_IMPORTS)
+static void profile_dump(void) {
+  profile_report(PROFILE_PATH);
+}
+#endif
+
 int check_kubridge(void) {
   int search_unk[2];
   return _vshKernelSearchModuleByName("kubridge", search_unk);
@@ -640,26 +848,62 @@ int main(int argc, char *argv[]) {
   if (!file_exists("ur0:/data/libshacccg.suprx") && !file_exists("ur0:/data/external/libshacccg.suprx"))
     fatal_error("Error libshacccg.suprx is not installed.");
 
-  if (so_load(&conduit_mod, SO_PATH, LOAD_ADDRESS) < 0)
-    fatal_error("Error could not load %s.", SO_PATH);
+#ifdef LOADER_BENCHMARK
+  for (int i = 0; i < LOADER_BENCHMARK; i++) {
+    SceUInt64 t_cycle = sceKernelGetProcessTimeWide();
+    if (so_reload(&conduit_mod, SO_PATH, LOAD_ADDRESS, default_dynlib, sizeof(default_dynlib), 0, &conduit_pipeline) < 0)
+      fatal_error("Error could not load %s.", SO_PATH);
+    debugPrintf("Loader benchmark %d: %llu us\n", i, sceKernelGetProcessTimeWide() - t_cycle);
+  }
+  so_unload(&conduit_mod);
+#endif
 
-  so_relocate(&conduit_mod);
-  so_resolve(&conduit_mod, default_dynlib, sizeof(default_dynlib), 0);
+  SceUInt64 t_start = sceKernelGetProcessTimeWide();
 
-  patch_mpg123();
-  patch_openal();
-  patch_game();
-  patch_movie();
-  so_flush_caches(&conduit_mod);
+  if (file_exists(SO_PATH)) {
+    if (so_load(&conduit_mod, SO_PATH, LOAD_ADDRESS) < 0)
+      fatal_error("Error could not load %s.", SO_PATH);
+  } else {
+    if (so_load_apk(&conduit_mod, APK_PATH, APK_SO_ENTRY, LOAD_ADDRESS) < 0)
+      fatal_error("Error could not load %s from %s.", APK_SO_ENTRY, APK_PATH);
+  }
+
+  SceUInt64 t_load = sceKernelGetProcessTimeWide();
+
+  if (so_link(&conduit_mod, default_dynlib, sizeof(default_dynlib), 0, &conduit_pipeline) < 0)
+    fatal_error("Error could not link %s.", SO_PATH);
+
+  SceUInt64 t_link = sceKernelGetProcessTimeWide();
+
+#ifdef LAZY_BIND
+  atexit(lazy_bind_report);
+#endif
+
+#if defined(PROFILE) || defined(PROFILE_IMPORTS)
+  atexit(profile_dump);
+  profile_flush_start(PROFILE_PATH, PROFILE_FLUSH_INTERVAL);
+#endif
+
+  debugPrintf("Boot timings: load %llu us, link %llu us, patch %llu us\n",
+              t_load - t_start, t_link - t_load - patch_time, patch_time);
 
   so_initialize(&conduit_mod);
 
   if (fios_init() < 0)
     fatal_error("Error could not initialize fios.");
 
+  if (program_cache_init(PROGRAM_CACHE_PATH) < 0)
+    debugPrintf("Error could not open %s\n", PROGRAM_CACHE_PATH);
+  atexit(program_cache_report);
+
   vglSetupGarbageCollector(127, 0x10000);
   vglInitExtended(0, SCREEN_W, SCREEN_H, MEMORY_VITAGL_THRESHOLD_MB * 1024 * 1024, SCE_GXM_MULTISAMPLE_4X);
 
+  // Uses the libshacccg that vitaGL loaded. glCompileShader is stubbed, so vitaGL never compiles
+  // anything itself and the compiler thread is the only caller.
+  if (shader_compiler_start(&shader_compiler_shacccg, SHADER_OVERLAY_PATH) < 0)
+    debugPrintf("Error could not start the shader compiler\n");
+
   movie_setup_player();
 
   jni_load();
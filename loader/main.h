@@ -13,4 +13,6 @@ int debugPrintf(char *text, ...);
 
 int ret0();
 
+void shader_swap_ready(void);
+
 #endif
@@ -16,6 +16,7 @@
 #include "main.h"
 #include "config.h"
 #include "so_util.h"
+#include "hook_offsets.h"
 
 #include "shaders/movie_f.h"
 #include "shaders/movie_v.h"
@@ -288,6 +289,13 @@ int OS_MovieIsPlaying(int *loops) {
 void OS_MovieSetSkippable(void) {
 }
 
+static so_hook movie_hooks[] = {
+  { "_Z12OS_MoviePlayPKcbbf", (uintptr_t)OS_MoviePlay },
+  { "_Z20OS_MovieSetSkippableb", (uintptr_t)OS_MovieSetSkippable },
+  { "_Z12OS_MovieStopv", (uintptr_t)OS_MovieStop },
+  { "_Z17OS_MovieIsPlayingPi", (uintptr_t)OS_MovieIsPlaying },
+};
+
 void patch_movie(void) {
   OS_FileOpen = (void *)so_symbol(&conduit_mod, "_Z11OS_FileOpen14OSFileDataAreaPPvPKc16OSFileAccessType");
   OS_FileRead = (void *)so_symbol(&conduit_mod, "_Z11OS_FileReadPvS_i");
@@ -295,8 +303,5 @@ void patch_movie(void) {
   OS_FileSize = (void *)so_symbol(&conduit_mod, "_Z11OS_FileSizePv");
   OS_FileClose = (void *)so_symbol(&conduit_mod, "_Z12OS_FileClosePv");
 
-  hook_addr(so_symbol(&conduit_mod, "_Z12OS_MoviePlayPKcbbf"), (uintptr_t)OS_MoviePlay);
-  hook_addr(so_symbol(&conduit_mod, "_Z20OS_MovieSetSkippableb"), (uintptr_t)OS_MovieSetSkippable);
-  hook_addr(so_symbol(&conduit_mod, "_Z12OS_MovieStopv"), (uintptr_t)OS_MovieStop);
-  hook_addr(so_symbol(&conduit_mod, "_Z17OS_MovieIsPlayingPi"), (uintptr_t)OS_MovieIsPlaying);
+  so_hook_table(&conduit_mod, movie_hooks, sizeof(movie_hooks), &movie_hooks_offsets);
 }
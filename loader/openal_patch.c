@@ -15,262 +15,266 @@
 
 #include "main.h"
 #include "so_util.h"
+#include "hook_offsets.h"
 
-void patch_openal(void) {
-  hook_addr(so_symbol(&conduit_mod, "alAuxiliaryEffectSlotf"), (uintptr_t)&alAuxiliaryEffectSlotf);
-  hook_addr(so_symbol(&conduit_mod, "alAuxiliaryEffectSlotfv"), (uintptr_t)&alAuxiliaryEffectSlotfv);
-  hook_addr(so_symbol(&conduit_mod, "alAuxiliaryEffectSloti"), (uintptr_t)&alAuxiliaryEffectSloti);
-  hook_addr(so_symbol(&conduit_mod, "alAuxiliaryEffectSlotiv"), (uintptr_t)&alAuxiliaryEffectSlotiv);
-  hook_addr(so_symbol(&conduit_mod, "alBuffer3f"), (uintptr_t)&alBuffer3f);
-  hook_addr(so_symbol(&conduit_mod, "alBuffer3i"), (uintptr_t)&alBuffer3i);
-  hook_addr(so_symbol(&conduit_mod, "alBufferData"), (uintptr_t)&alBufferData);
-  hook_addr(so_symbol(&conduit_mod, "alBufferf"), (uintptr_t)&alBufferf);
-  hook_addr(so_symbol(&conduit_mod, "alBufferfv"), (uintptr_t)&alBufferfv);
-  hook_addr(so_symbol(&conduit_mod, "alBufferi"), (uintptr_t)&alBufferi);
-  hook_addr(so_symbol(&conduit_mod, "alBufferiv"), (uintptr_t)&alBufferiv);
-  hook_addr(so_symbol(&conduit_mod, "alDeleteAuxiliaryEffectSlots"), (uintptr_t)&alDeleteAuxiliaryEffectSlots);
-  hook_addr(so_symbol(&conduit_mod, "alDeleteBuffers"), (uintptr_t)&alDeleteBuffers);
-  hook_addr(so_symbol(&conduit_mod, "alDeleteEffects"), (uintptr_t)&alDeleteEffects);
-  hook_addr(so_symbol(&conduit_mod, "alDeleteFilters"), (uintptr_t)&alDeleteFilters);
-  hook_addr(so_symbol(&conduit_mod, "alDeleteSources"), (uintptr_t)&alDeleteSources);
-  hook_addr(so_symbol(&conduit_mod, "alDisable"), (uintptr_t)&alDisable);
-  hook_addr(so_symbol(&conduit_mod, "alDistanceModel"), (uintptr_t)&alDistanceModel);
-  hook_addr(so_symbol(&conduit_mod, "alDopplerFactor"), (uintptr_t)&alDopplerFactor);
-  hook_addr(so_symbol(&conduit_mod, "alDopplerVelocity"), (uintptr_t)&alDopplerVelocity);
-  hook_addr(so_symbol(&conduit_mod, "alEffectf"), (uintptr_t)&alEffectf);
-  hook_addr(so_symbol(&conduit_mod, "alEffectfv"), (uintptr_t)&alEffectfv);
-  hook_addr(so_symbol(&conduit_mod, "alEffecti"), (uintptr_t)&alEffecti);
-  hook_addr(so_symbol(&conduit_mod, "alEffectiv"), (uintptr_t)&alEffectiv);
-  hook_addr(so_symbol(&conduit_mod, "alEnable"), (uintptr_t)&alEnable);
-  hook_addr(so_symbol(&conduit_mod, "alFilterf"), (uintptr_t)&alFilterf);
-  hook_addr(so_symbol(&conduit_mod, "alFilterfv"), (uintptr_t)&alFilterfv);
-  hook_addr(so_symbol(&conduit_mod, "alFilteri"), (uintptr_t)&alFilteri);
-  hook_addr(so_symbol(&conduit_mod, "alFilteriv"), (uintptr_t)&alFilteriv);
-  hook_addr(so_symbol(&conduit_mod, "alGenAuxiliaryEffectSlots"), (uintptr_t)&alGenAuxiliaryEffectSlots);
-  hook_addr(so_symbol(&conduit_mod, "alGenBuffers"), (uintptr_t)&alGenBuffers);
-  hook_addr(so_symbol(&conduit_mod, "alGenEffects"), (uintptr_t)&alGenEffects);
-  hook_addr(so_symbol(&conduit_mod, "alGenFilters"), (uintptr_t)&alGenFilters);
-  hook_addr(so_symbol(&conduit_mod, "alGenSources"), (uintptr_t)&alGenSources);
-  hook_addr(so_symbol(&conduit_mod, "alGetAuxiliaryEffectSlotf"), (uintptr_t)&alGetAuxiliaryEffectSlotf);
-  hook_addr(so_symbol(&conduit_mod, "alGetAuxiliaryEffectSlotfv"), (uintptr_t)&alGetAuxiliaryEffectSlotfv);
-  hook_addr(so_symbol(&conduit_mod, "alGetAuxiliaryEffectSloti"), (uintptr_t)&alGetAuxiliaryEffectSloti);
-  hook_addr(so_symbol(&conduit_mod, "alGetAuxiliaryEffectSlotiv"), (uintptr_t)&alGetAuxiliaryEffectSlotiv);
-  hook_addr(so_symbol(&conduit_mod, "alGetBoolean"), (uintptr_t)&alGetBoolean);
-  hook_addr(so_symbol(&conduit_mod, "alGetBooleanv"), (uintptr_t)&alGetBooleanv);
-  hook_addr(so_symbol(&conduit_mod, "alGetBuffer3f"), (uintptr_t)&alGetBuffer3f);
-  hook_addr(so_symbol(&conduit_mod, "alGetBuffer3i"), (uintptr_t)&alGetBuffer3i);
-  hook_addr(so_symbol(&conduit_mod, "alGetBufferf"), (uintptr_t)&alGetBufferf);
-  hook_addr(so_symbol(&conduit_mod, "alGetBufferfv"), (uintptr_t)&alGetBufferfv);
-  hook_addr(so_symbol(&conduit_mod, "alGetBufferi"), (uintptr_t)&alGetBufferi);
-  hook_addr(so_symbol(&conduit_mod, "alGetBufferiv"), (uintptr_t)&alGetBufferiv);
-  hook_addr(so_symbol(&conduit_mod, "alGetDouble"), (uintptr_t)&alGetDouble);
-  hook_addr(so_symbol(&conduit_mod, "alGetDoublev"), (uintptr_t)&alGetDoublev);
-  hook_addr(so_symbol(&conduit_mod, "alGetEffectf"), (uintptr_t)&alGetEffectf);
-  hook_addr(so_symbol(&conduit_mod, "alGetEffectfv"), (uintptr_t)&alGetEffectfv);
-  hook_addr(so_symbol(&conduit_mod, "alGetEffecti"), (uintptr_t)&alGetEffecti);
-  hook_addr(so_symbol(&conduit_mod, "alGetEffectiv"), (uintptr_t)&alGetEffectiv);
-  hook_addr(so_symbol(&conduit_mod, "alGetEnumValue"), (uintptr_t)&alGetEnumValue);
-  hook_addr(so_symbol(&conduit_mod, "alGetError"), (uintptr_t)&alGetError);
-  hook_addr(so_symbol(&conduit_mod, "alGetFilterf"), (uintptr_t)&alGetFilterf);
-  hook_addr(so_symbol(&conduit_mod, "alGetFilterfv"), (uintptr_t)&alGetFilterfv);
-  hook_addr(so_symbol(&conduit_mod, "alGetFilteri"), (uintptr_t)&alGetFilteri);
-  hook_addr(so_symbol(&conduit_mod, "alGetFilteriv"), (uintptr_t)&alGetFilteriv);
-  hook_addr(so_symbol(&conduit_mod, "alGetFloat"), (uintptr_t)&alGetFloat);
-  hook_addr(so_symbol(&conduit_mod, "alGetFloatv"), (uintptr_t)&alGetFloatv);
-  hook_addr(so_symbol(&conduit_mod, "alGetInteger"), (uintptr_t)&alGetInteger);
-  hook_addr(so_symbol(&conduit_mod, "alGetIntegerv"), (uintptr_t)&alGetIntegerv);
-  hook_addr(so_symbol(&conduit_mod, "alGetListener3f"), (uintptr_t)&alGetListener3f);
-  hook_addr(so_symbol(&conduit_mod, "alGetListener3i"), (uintptr_t)&alGetListener3i);
-  hook_addr(so_symbol(&conduit_mod, "alGetListenerf"), (uintptr_t)&alGetListenerf);
-  hook_addr(so_symbol(&conduit_mod, "alGetListenerfv"), (uintptr_t)&alGetListenerfv);
-  hook_addr(so_symbol(&conduit_mod, "alGetListeneri"), (uintptr_t)&alGetListeneri);
-  hook_addr(so_symbol(&conduit_mod, "alGetListeneriv"), (uintptr_t)&alGetListeneriv);
-  hook_addr(so_symbol(&conduit_mod, "alGetProcAddress"), (uintptr_t)&alGetProcAddress);
-  hook_addr(so_symbol(&conduit_mod, "alGetSource3f"), (uintptr_t)&alGetSource3f);
-  hook_addr(so_symbol(&conduit_mod, "alGetSource3i"), (uintptr_t)&alGetSource3i);
-  hook_addr(so_symbol(&conduit_mod, "alGetSourcef"), (uintptr_t)&alGetSourcef);
-  hook_addr(so_symbol(&conduit_mod, "alGetSourcefv"), (uintptr_t)&alGetSourcefv);
-  hook_addr(so_symbol(&conduit_mod, "alGetSourcei"), (uintptr_t)&alGetSourcei);
-  hook_addr(so_symbol(&conduit_mod, "alGetSourceiv"), (uintptr_t)&alGetSourceiv);
-  hook_addr(so_symbol(&conduit_mod, "alGetString"), (uintptr_t)&alGetString);
-  hook_addr(so_symbol(&conduit_mod, "alIsAuxiliaryEffectSlot"), (uintptr_t)&alIsAuxiliaryEffectSlot);
-  hook_addr(so_symbol(&conduit_mod, "alIsBuffer"), (uintptr_t)&alIsBuffer);
-  hook_addr(so_symbol(&conduit_mod, "alIsEffect"), (uintptr_t)&alIsEffect);
-  hook_addr(so_symbol(&conduit_mod, "alIsEnabled"), (uintptr_t)&alIsEnabled);
-  hook_addr(so_symbol(&conduit_mod, "alIsExtensionPresent"), (uintptr_t)&alIsExtensionPresent);
-  hook_addr(so_symbol(&conduit_mod, "alIsFilter"), (uintptr_t)&alIsFilter);
-  hook_addr(so_symbol(&conduit_mod, "alIsSource"), (uintptr_t)&alIsSource);
-  hook_addr(so_symbol(&conduit_mod, "alListener3f"), (uintptr_t)&alListener3f);
-  hook_addr(so_symbol(&conduit_mod, "alListener3i"), (uintptr_t)&alListener3i);
-  hook_addr(so_symbol(&conduit_mod, "alListenerf"), (uintptr_t)&alListenerf);
-  hook_addr(so_symbol(&conduit_mod, "alListenerfv"), (uintptr_t)&alListenerfv);
-  hook_addr(so_symbol(&conduit_mod, "alListeneri"), (uintptr_t)&alListeneri);
-  hook_addr(so_symbol(&conduit_mod, "alListeneriv"), (uintptr_t)&alListeneriv);
-  hook_addr(so_symbol(&conduit_mod, "alSource3f"), (uintptr_t)&alSource3f);
-  hook_addr(so_symbol(&conduit_mod, "alSource3i"), (uintptr_t)&alSource3i);
-  hook_addr(so_symbol(&conduit_mod, "alSourcePause"), (uintptr_t)&alSourcePause);
-  hook_addr(so_symbol(&conduit_mod, "alSourcePausev"), (uintptr_t)&alSourcePausev);
-  hook_addr(so_symbol(&conduit_mod, "alSourcePlay"), (uintptr_t)&alSourcePlay);
-  hook_addr(so_symbol(&conduit_mod, "alSourcePlayv"), (uintptr_t)&alSourcePlayv);
-  hook_addr(so_symbol(&conduit_mod, "alSourceQueueBuffers"), (uintptr_t)&alSourceQueueBuffers);
-  hook_addr(so_symbol(&conduit_mod, "alSourceRewind"), (uintptr_t)&alSourceRewind);
-  hook_addr(so_symbol(&conduit_mod, "alSourceRewindv"), (uintptr_t)&alSourceRewindv);
-  hook_addr(so_symbol(&conduit_mod, "alSourceStop"), (uintptr_t)&alSourceStop);
-  hook_addr(so_symbol(&conduit_mod, "alSourceStopv"), (uintptr_t)&alSourceStopv);
-  hook_addr(so_symbol(&conduit_mod, "alSourceUnqueueBuffers"), (uintptr_t)&alSourceUnqueueBuffers);
-  hook_addr(so_symbol(&conduit_mod, "alSourcef"), (uintptr_t)&alSourcef);
-  hook_addr(so_symbol(&conduit_mod, "alSourcefv"), (uintptr_t)&alSourcefv);
-  hook_addr(so_symbol(&conduit_mod, "alSourcei"), (uintptr_t)&alSourcei);
-  hook_addr(so_symbol(&conduit_mod, "alSourceiv"), (uintptr_t)&alSourceiv);
-  hook_addr(so_symbol(&conduit_mod, "alSpeedOfSound"), (uintptr_t)&alSpeedOfSound);
-  hook_addr(so_symbol(&conduit_mod, "alcCaptureCloseDevice"), (uintptr_t)&alcCaptureCloseDevice);
-  hook_addr(so_symbol(&conduit_mod, "alcCaptureOpenDevice"), (uintptr_t)&alcCaptureOpenDevice);
-  hook_addr(so_symbol(&conduit_mod, "alcCaptureSamples"), (uintptr_t)&alcCaptureSamples);
-  hook_addr(so_symbol(&conduit_mod, "alcCaptureStart"), (uintptr_t)&alcCaptureStart);
-  hook_addr(so_symbol(&conduit_mod, "alcCaptureStop"), (uintptr_t)&alcCaptureStop);
-  hook_addr(so_symbol(&conduit_mod, "alcCloseDevice"), (uintptr_t)&alcCloseDevice);
-  hook_addr(so_symbol(&conduit_mod, "alcCreateContext"), (uintptr_t)&alcCreateContext);
-  hook_addr(so_symbol(&conduit_mod, "alcDestroyContext"), (uintptr_t)&alcDestroyContext);
-  hook_addr(so_symbol(&conduit_mod, "alcGetContextsDevice"), (uintptr_t)&alcGetContextsDevice);
-  hook_addr(so_symbol(&conduit_mod, "alcGetCurrentContext"), (uintptr_t)&alcGetCurrentContext);
-  hook_addr(so_symbol(&conduit_mod, "alcGetEnumValue"), (uintptr_t)&alcGetEnumValue);
-  hook_addr(so_symbol(&conduit_mod, "alcGetError"), (uintptr_t)&alcGetError);
-  hook_addr(so_symbol(&conduit_mod, "alcGetIntegerv"), (uintptr_t)&alcGetIntegerv);
-  hook_addr(so_symbol(&conduit_mod, "alcGetString"), (uintptr_t)&alcGetString);
-  hook_addr(so_symbol(&conduit_mod, "alcGetThreadContext"), (uintptr_t)&alcGetThreadContext);
-  hook_addr(so_symbol(&conduit_mod, "alcIsExtensionPresent"), (uintptr_t)&alcIsExtensionPresent);
-  hook_addr(so_symbol(&conduit_mod, "alcMakeContextCurrent"), (uintptr_t)&alcMakeContextCurrent);
-  hook_addr(so_symbol(&conduit_mod, "alcOpenDevice"), (uintptr_t)&alcOpenDevice);
-  hook_addr(so_symbol(&conduit_mod, "alcProcessContext"), (uintptr_t)&alcProcessContext);
-  hook_addr(so_symbol(&conduit_mod, "alcSetThreadContext"), (uintptr_t)&alcSetThreadContext);
-  hook_addr(so_symbol(&conduit_mod, "alcSuspendContext"), (uintptr_t)&alcSuspendContext);
+static so_hook openal_hooks[] = {
+  { "alAuxiliaryEffectSlotf", (uintptr_t)&alAuxiliaryEffectSlotf },
+  { "alAuxiliaryEffectSlotfv", (uintptr_t)&alAuxiliaryEffectSlotfv },
+  { "alAuxiliaryEffectSloti", (uintptr_t)&alAuxiliaryEffectSloti },
+  { "alAuxiliaryEffectSlotiv", (uintptr_t)&alAuxiliaryEffectSlotiv },
+  { "alBuffer3f", (uintptr_t)&alBuffer3f },
+  { "alBuffer3i", (uintptr_t)&alBuffer3i },
+  { "alBufferData", (uintptr_t)&alBufferData },
+  { "alBufferf", (uintptr_t)&alBufferf },
+  { "alBufferfv", (uintptr_t)&alBufferfv },
+  { "alBufferi", (uintptr_t)&alBufferi },
+  { "alBufferiv", (uintptr_t)&alBufferiv },
+  { "alDeleteAuxiliaryEffectSlots", (uintptr_t)&alDeleteAuxiliaryEffectSlots },
+  { "alDeleteBuffers", (uintptr_t)&alDeleteBuffers },
+  { "alDeleteEffects", (uintptr_t)&alDeleteEffects },
+  { "alDeleteFilters", (uintptr_t)&alDeleteFilters },
+  { "alDeleteSources", (uintptr_t)&alDeleteSources },
+  { "alDisable", (uintptr_t)&alDisable },
+  { "alDistanceModel", (uintptr_t)&alDistanceModel },
+  { "alDopplerFactor", (uintptr_t)&alDopplerFactor },
+  { "alDopplerVelocity", (uintptr_t)&alDopplerVelocity },
+  { "alEffectf", (uintptr_t)&alEffectf },
+  { "alEffectfv", (uintptr_t)&alEffectfv },
+  { "alEffecti", (uintptr_t)&alEffecti },
+  { "alEffectiv", (uintptr_t)&alEffectiv },
+  { "alEnable", (uintptr_t)&alEnable },
+  { "alFilterf", (uintptr_t)&alFilterf },
+  { "alFilterfv", (uintptr_t)&alFilterfv },
+  { "alFilteri", (uintptr_t)&alFilteri },
+  { "alFilteriv", (uintptr_t)&alFilteriv },
+  { "alGenAuxiliaryEffectSlots", (uintptr_t)&alGenAuxiliaryEffectSlots },
+  { "alGenBuffers", (uintptr_t)&alGenBuffers },
+  { "alGenEffects", (uintptr_t)&alGenEffects },
+  { "alGenFilters", (uintptr_t)&alGenFilters },
+  { "alGenSources", (uintptr_t)&alGenSources },
+  { "alGetAuxiliaryEffectSlotf", (uintptr_t)&alGetAuxiliaryEffectSlotf },
+  { "alGetAuxiliaryEffectSlotfv", (uintptr_t)&alGetAuxiliaryEffectSlotfv },
+  { "alGetAuxiliaryEffectSloti", (uintptr_t)&alGetAuxiliaryEffectSloti },
+  { "alGetAuxiliaryEffectSlotiv", (uintptr_t)&alGetAuxiliaryEffectSlotiv },
+  { "alGetBoolean", (uintptr_t)&alGetBoolean },
+  { "alGetBooleanv", (uintptr_t)&alGetBooleanv },
+  { "alGetBuffer3f", (uintptr_t)&alGetBuffer3f },
+  { "alGetBuffer3i", (uintptr_t)&alGetBuffer3i },
+  { "alGetBufferf", (uintptr_t)&alGetBufferf },
+  { "alGetBufferfv", (uintptr_t)&alGetBufferfv },
+  { "alGetBufferi", (uintptr_t)&alGetBufferi },
+  { "alGetBufferiv", (uintptr_t)&alGetBufferiv },
+  { "alGetDouble", (uintptr_t)&alGetDouble },
+  { "alGetDoublev", (uintptr_t)&alGetDoublev },
+  { "alGetEffectf", (uintptr_t)&alGetEffectf },
+  { "alGetEffectfv", (uintptr_t)&alGetEffectfv },
+  { "alGetEffecti", (uintptr_t)&alGetEffecti },
+  { "alGetEffectiv", (uintptr_t)&alGetEffectiv },
+  { "alGetEnumValue", (uintptr_t)&alGetEnumValue },
+  { "alGetError", (uintptr_t)&alGetError },
+  { "alGetFilterf", (uintptr_t)&alGetFilterf },
+  { "alGetFilterfv", (uintptr_t)&alGetFilterfv },
+  { "alGetFilteri", (uintptr_t)&alGetFilteri },
+  { "alGetFilteriv", (uintptr_t)&alGetFilteriv },
+  { "alGetFloat", (uintptr_t)&alGetFloat },
+  { "alGetFloatv", (uintptr_t)&alGetFloatv },
+  { "alGetInteger", (uintptr_t)&alGetInteger },
+  { "alGetIntegerv", (uintptr_t)&alGetIntegerv },
+  { "alGetListener3f", (uintptr_t)&alGetListener3f },
+  { "alGetListener3i", (uintptr_t)&alGetListener3i },
+  { "alGetListenerf", (uintptr_t)&alGetListenerf },
+  { "alGetListenerfv", (uintptr_t)&alGetListenerfv },
+  { "alGetListeneri", (uintptr_t)&alGetListeneri },
+  { "alGetListeneriv", (uintptr_t)&alGetListeneriv },
+  { "alGetProcAddress", (uintptr_t)&alGetProcAddress },
+  { "alGetSource3f", (uintptr_t)&alGetSource3f },
+  { "alGetSource3i", (uintptr_t)&alGetSource3i },
+  { "alGetSourcef", (uintptr_t)&alGetSourcef },
+  { "alGetSourcefv", (uintptr_t)&alGetSourcefv },
+  { "alGetSourcei", (uintptr_t)&alGetSourcei },
+  { "alGetSourceiv", (uintptr_t)&alGetSourceiv },
+  { "alGetString", (uintptr_t)&alGetString },
+  { "alIsAuxiliaryEffectSlot", (uintptr_t)&alIsAuxiliaryEffectSlot },
+  { "alIsBuffer", (uintptr_t)&alIsBuffer },
+  { "alIsEffect", (uintptr_t)&alIsEffect },
+  { "alIsEnabled", (uintptr_t)&alIsEnabled },
+  { "alIsExtensionPresent", (uintptr_t)&alIsExtensionPresent },
+  { "alIsFilter", (uintptr_t)&alIsFilter },
+  { "alIsSource", (uintptr_t)&alIsSource },
+  { "alListener3f", (uintptr_t)&alListener3f },
+  { "alListener3i", (uintptr_t)&alListener3i },
+  { "alListenerf", (uintptr_t)&alListenerf },
+  { "alListenerfv", (uintptr_t)&alListenerfv },
+  { "alListeneri", (uintptr_t)&alListeneri },
+  { "alListeneriv", (uintptr_t)&alListeneriv },
+  { "alSource3f", (uintptr_t)&alSource3f },
+  { "alSource3i", (uintptr_t)&alSource3i },
+  { "alSourcePause", (uintptr_t)&alSourcePause },
+  { "alSourcePausev", (uintptr_t)&alSourcePausev },
+  { "alSourcePlay", (uintptr_t)&alSourcePlay },
+  { "alSourcePlayv", (uintptr_t)&alSourcePlayv },
+  { "alSourceQueueBuffers", (uintptr_t)&alSourceQueueBuffers },
+  { "alSourceRewind", (uintptr_t)&alSourceRewind },
+  { "alSourceRewindv", (uintptr_t)&alSourceRewindv },
+  { "alSourceStop", (uintptr_t)&alSourceStop },
+  { "alSourceStopv", (uintptr_t)&alSourceStopv },
+  { "alSourceUnqueueBuffers", (uintptr_t)&alSourceUnqueueBuffers },
+  { "alSourcef", (uintptr_t)&alSourcef },
+  { "alSourcefv", (uintptr_t)&alSourcefv },
+  { "alSourcei", (uintptr_t)&alSourcei },
+  { "alSourceiv", (uintptr_t)&alSourceiv },
+  { "alSpeedOfSound", (uintptr_t)&alSpeedOfSound },
+  { "alcCaptureCloseDevice", (uintptr_t)&alcCaptureCloseDevice },
+  { "alcCaptureOpenDevice", (uintptr_t)&alcCaptureOpenDevice },
+  { "alcCaptureSamples", (uintptr_t)&alcCaptureSamples },
+  { "alcCaptureStart", (uintptr_t)&alcCaptureStart },
+  { "alcCaptureStop", (uintptr_t)&alcCaptureStop },
+  { "alcCloseDevice", (uintptr_t)&alcCloseDevice },
+  { "alcCreateContext", (uintptr_t)&alcCreateContext },
+  { "alcDestroyContext", (uintptr_t)&alcDestroyContext },
+  { "alcGetContextsDevice", (uintptr_t)&alcGetContextsDevice },
+  { "alcGetCurrentContext", (uintptr_t)&alcGetCurrentContext },
+  { "alcGetEnumValue", (uintptr_t)&alcGetEnumValue },
+  { "alcGetError", (uintptr_t)&alcGetError },
+  { "alcGetIntegerv", (uintptr_t)&alcGetIntegerv },
+  { "alcGetString", (uintptr_t)&alcGetString },
+  { "alcGetThreadContext", (uintptr_t)&alcGetThreadContext },
+  { "alcIsExtensionPresent", (uintptr_t)&alcIsExtensionPresent },
+  { "alcMakeContextCurrent", (uintptr_t)&alcMakeContextCurrent },
+  { "alcOpenDevice", (uintptr_t)&alcOpenDevice },
+  { "alcProcessContext", (uintptr_t)&alcProcessContext },
+  { "alcSetThreadContext", (uintptr_t)&alcSetThreadContext },
+  { "alcSuspendContext", (uintptr_t)&alcSuspendContext },
 
+  // { "alAuxiliaryEffectSlotf", (uintptr_t)&ret0 },
+  // { "alAuxiliaryEffectSlotfv", (uintptr_t)&ret0 },
+  // { "alAuxiliaryEffectSloti", (uintptr_t)&ret0 },
+  // { "alAuxiliaryEffectSlotiv", (uintptr_t)&ret0 },
+  // { "alBuffer3f", (uintptr_t)&ret0 },
+  // { "alBuffer3i", (uintptr_t)&ret0 },
+  // { "alBufferData", (uintptr_t)&ret0 },
+  // { "alBufferf", (uintptr_t)&ret0 },
+  // { "alBufferfv", (uintptr_t)&ret0 },
+  // { "alBufferi", (uintptr_t)&ret0 },
+  // { "alBufferiv", (uintptr_t)&ret0 },
+  // { "alDeleteAuxiliaryEffectSlots", (uintptr_t)&ret0 },
+  // { "alDeleteBuffers", (uintptr_t)&ret0 },
+  // { "alDeleteEffects", (uintptr_t)&ret0 },
+  // { "alDeleteFilters", (uintptr_t)&ret0 },
+  // { "alDeleteSources", (uintptr_t)&ret0 },
+  // { "alDisable", (uintptr_t)&ret0 },
+  // { "alDistanceModel", (uintptr_t)&ret0 },
+  // { "alDopplerFactor", (uintptr_t)&ret0 },
+  // { "alDopplerVelocity", (uintptr_t)&ret0 },
+  // { "alEffectf", (uintptr_t)&ret0 },
+  // { "alEffectfv", (uintptr_t)&ret0 },
+  // { "alEffecti", (uintptr_t)&ret0 },
+  // { "alEffectiv", (uintptr_t)&ret0 },
+  // { "alEnable", (uintptr_t)&ret0 },
+  // { "alFilterf", (uintptr_t)&ret0 },
+  // { "alFilterfv", (uintptr_t)&ret0 },
+  // { "alFilteri", (uintptr_t)&ret0 },
+  // { "alFilteriv", (uintptr_t)&ret0 },
+  // { "alGenAuxiliaryEffectSlots", (uintptr_t)&ret0 },
+  // { "alGenBuffers", (uintptr_t)&ret0 },
+  // { "alGenEffects", (uintptr_t)&ret0 },
+  // { "alGenFilters", (uintptr_t)&ret0 },
+  // { "alGenSources", (uintptr_t)&ret0 },
+  // { "alGetAuxiliaryEffectSlotf", (uintptr_t)&ret0 },
+  // { "alGetAuxiliaryEffectSlotfv", (uintptr_t)&ret0 },
+  // { "alGetAuxiliaryEffectSloti", (uintptr_t)&ret0 },
+  // { "alGetAuxiliaryEffectSlotiv", (uintptr_t)&ret0 },
+  // { "alGetBoolean", (uintptr_t)&ret0 },
+  // { "alGetBooleanv", (uintptr_t)&ret0 },
+  // { "alGetBuffer3f", (uintptr_t)&ret0 },
+  // { "alGetBuffer3i", (uintptr_t)&ret0 },
+  // { "alGetBufferf", (uintptr_t)&ret0 },
+  // { "alGetBufferfv", (uintptr_t)&ret0 },
+  // { "alGetBufferi", (uintptr_t)&ret0 },
+  // { "alGetBufferiv", (uintptr_t)&ret0 },
+  // { "alGetDouble", (uintptr_t)&ret0 },
+  // { "alGetDoublev", (uintptr_t)&ret0 },
+  // { "alGetEffectf", (uintptr_t)&ret0 },
+  // { "alGetEffectfv", (uintptr_t)&ret0 },
+  // { "alGetEffecti", (uintptr_t)&ret0 },
+  // { "alGetEffectiv", (uintptr_t)&ret0 },
+  // { "alGetEnumValue", (uintptr_t)&ret0 },
+  // { "alGetError", (uintptr_t)&ret0 },
+  // { "alGetFilterf", (uintptr_t)&ret0 },
+  // { "alGetFilterfv", (uintptr_t)&ret0 },
+  // { "alGetFilteri", (uintptr_t)&ret0 },
+  // { "alGetFilteriv", (uintptr_t)&ret0 },
+  // { "alGetFloat", (uintptr_t)&ret0 },
+  // { "alGetFloatv", (uintptr_t)&ret0 },
+  // { "alGetInteger", (uintptr_t)&ret0 },
+  // { "alGetIntegerv", (uintptr_t)&ret0 },
+  // { "alGetListener3f", (uintptr_t)&ret0 },
+  // { "alGetListener3i", (uintptr_t)&ret0 },
+  // { "alGetListenerf", (uintptr_t)&ret0 },
+  // { "alGetListenerfv", (uintptr_t)&ret0 },
+  // { "alGetListeneri", (uintptr_t)&ret0 },
+  // { "alGetListeneriv", (uintptr_t)&ret0 },
+  // { "alGetProcAddress", (uintptr_t)&ret0 },
+  // { "alGetSource3f", (uintptr_t)&ret0 },
+  // { "alGetSource3i", (uintptr_t)&ret0 },
+  // { "alGetSourcef", (uintptr_t)&ret0 },
+  // { "alGetSourcefv", (uintptr_t)&ret0 },
+  // { "alGetSourcei", (uintptr_t)&ret0 },
+  // { "alGetSourceiv", (uintptr_t)&ret0 },
+  // { "alGetString", (uintptr_t)&ret0 },
+  // { "alIsAuxiliaryEffectSlot", (uintptr_t)&ret0 },
+  // { "alIsBuffer", (uintptr_t)&ret0 },
+  // { "alIsEffect", (uintptr_t)&ret0 },
+  // { "alIsEnabled", (uintptr_t)&ret0 },
+  // { "alIsExtensionPresent", (uintptr_t)&ret0 },
+  // { "alIsFilter", (uintptr_t)&ret0 },
+  // { "alIsSource", (uintptr_t)&ret0 },
+  // { "alListener3f", (uintptr_t)&ret0 },
+  // { "alListener3i", (uintptr_t)&ret0 },
+  // { "alListenerf", (uintptr_t)&ret0 },
+  // { "alListenerfv", (uintptr_t)&ret0 },
+  // { "alListeneri", (uintptr_t)&ret0 },
+  // { "alListeneriv", (uintptr_t)&ret0 },
+  // { "alSource3f", (uintptr_t)&ret0 },
+  // { "alSource3i", (uintptr_t)&ret0 },
+  // { "alSourcePause", (uintptr_t)&ret0 },
+  // { "alSourcePausev", (uintptr_t)&ret0 },
+  // { "alSourcePlay", (uintptr_t)&ret0 },
+  // { "alSourcePlayv", (uintptr_t)&ret0 },
+  // { "alSourceQueueBuffers", (uintptr_t)&ret0 },
+  // { "alSourceRewind", (uintptr_t)&ret0 },
+  // { "alSourceRewindv", (uintptr_t)&ret0 },
+  // { "alSourceStop", (uintptr_t)&ret0 },
+  // { "alSourceStopv", (uintptr_t)&ret0 },
+  // { "alSourceUnqueueBuffers", (uintptr_t)&ret0 },
+  // { "alSourcef", (uintptr_t)&ret0 },
+  // { "alSourcefv", (uintptr_t)&ret0 },
+  // { "alSourcei", (uintptr_t)&ret0 },
+  // { "alSourceiv", (uintptr_t)&ret0 },
+  // { "alSpeedOfSound", (uintptr_t)&ret0 },
+  // { "alcCaptureCloseDevice", (uintptr_t)&ret0 },
+  // { "alcCaptureOpenDevice", (uintptr_t)&ret0 },
+  // { "alcCaptureSamples", (uintptr_t)&ret0 },
+  // { "alcCaptureStart", (uintptr_t)&ret0 },
+  // { "alcCaptureStop", (uintptr_t)&ret0 },
+  // { "alcCloseDevice", (uintptr_t)&ret0 },
+  // { "alcCreateContext", (uintptr_t)&ret0 },
+  // { "alcDestroyContext", (uintptr_t)&ret0 },
+  // { "alcGetContextsDevice", (uintptr_t)&ret0 },
+  // { "alcGetCurrentContext", (uintptr_t)&ret0 },
+  // { "alcGetEnumValue", (uintptr_t)&ret0 },
+  // { "alcGetError", (uintptr_t)&ret0 },
+  // { "alcGetIntegerv", (uintptr_t)&ret0 },
+  // { "alcGetString", (uintptr_t)&ret0 },
+  // { "alcGetThreadContext", (uintptr_t)&ret0 },
+  // { "alcIsExtensionPresent", (uintptr_t)&ret0 },
+  // { "alcMakeContextCurrent", (uintptr_t)&ret0 },
+  // { "alcOpenDevice", (uintptr_t)&ret0 },
+  // { "alcProcessContext", (uintptr_t)&ret0 },
+  // { "alcSetThreadContext", (uintptr_t)&ret0 },
+  // { "alcSuspendContext", (uintptr_t)&ret0 },
+};
 
-  // hook_addr(so_symbol(&conduit_mod, "alAuxiliaryEffectSlotf"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alAuxiliaryEffectSlotfv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alAuxiliaryEffectSloti"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alAuxiliaryEffectSlotiv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alBuffer3f"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alBuffer3i"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alBufferData"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alBufferf"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alBufferfv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alBufferi"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alBufferiv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alDeleteAuxiliaryEffectSlots"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alDeleteBuffers"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alDeleteEffects"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alDeleteFilters"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alDeleteSources"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alDisable"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alDistanceModel"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alDopplerFactor"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alDopplerVelocity"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alEffectf"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alEffectfv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alEffecti"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alEffectiv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alEnable"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alFilterf"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alFilterfv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alFilteri"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alFilteriv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGenAuxiliaryEffectSlots"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGenBuffers"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGenEffects"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGenFilters"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGenSources"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetAuxiliaryEffectSlotf"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetAuxiliaryEffectSlotfv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetAuxiliaryEffectSloti"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetAuxiliaryEffectSlotiv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetBoolean"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetBooleanv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetBuffer3f"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetBuffer3i"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetBufferf"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetBufferfv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetBufferi"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetBufferiv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetDouble"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetDoublev"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetEffectf"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetEffectfv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetEffecti"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetEffectiv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetEnumValue"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetError"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetFilterf"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetFilterfv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetFilteri"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetFilteriv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetFloat"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetFloatv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetInteger"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetIntegerv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetListener3f"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetListener3i"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetListenerf"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetListenerfv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetListeneri"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetListeneriv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetProcAddress"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetSource3f"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetSource3i"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetSourcef"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetSourcefv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetSourcei"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetSourceiv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alGetString"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alIsAuxiliaryEffectSlot"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alIsBuffer"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alIsEffect"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alIsEnabled"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alIsExtensionPresent"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alIsFilter"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alIsSource"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alListener3f"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alListener3i"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alListenerf"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alListenerfv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alListeneri"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alListeneriv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSource3f"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSource3i"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourcePause"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourcePausev"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourcePlay"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourcePlayv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourceQueueBuffers"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourceRewind"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourceRewindv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourceStop"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourceStopv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourceUnqueueBuffers"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourcef"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourcefv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourcei"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSourceiv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alSpeedOfSound"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcCaptureCloseDevice"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcCaptureOpenDevice"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcCaptureSamples"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcCaptureStart"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcCaptureStop"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcCloseDevice"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcCreateContext"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcDestroyContext"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcGetContextsDevice"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcGetCurrentContext"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcGetEnumValue"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcGetError"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcGetIntegerv"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcGetString"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcGetThreadContext"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcIsExtensionPresent"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcMakeContextCurrent"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcOpenDevice"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcProcessContext"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcSetThreadContext"), ret0);
-  // hook_addr(so_symbol(&conduit_mod, "alcSuspendContext"), ret0);
+void patch_openal(void) {
+  so_hook_table(&conduit_mod, openal_hooks, sizeof(openal_hooks), &openal_hooks_offsets);
 }
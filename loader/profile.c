@@ -0,0 +1,337 @@
+/* profile.c -- per-function call instrumentation
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <vitasdk.h>
+#include <pthread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "dialog.h"
+#include "so_util.h"
+#include "trampoline.h"
+#include "profile.h"
+
+#define PROFILE_MAX_SYMBOLS 1024
+#define PROFILE_MAX_DEPTH 256
+#define PROFILE_MAX_CALLERS 4
+
+typedef struct {
+  const char *symbol;
+  uintptr_t orig;
+} profile_entry;
+
+typedef struct {
+  uintptr_t lr;
+  uint32_t count;
+} profile_caller;
+
+typedef struct {
+  uint32_t count;
+  uint64_t time;
+  profile_caller callers[PROFILE_MAX_CALLERS];
+} profile_stats;
+
+typedef struct {
+  int entry;
+  uintptr_t lr;
+  uint64_t start;
+} profile_frame;
+
+typedef struct profile_thread {
+  struct profile_thread *next;
+  int depth;
+  profile_frame frames[PROFILE_MAX_DEPTH];
+  profile_stats stats[PROFILE_MAX_SYMBOLS];
+} profile_thread;
+
+static so_module *profile_mod;
+static profile_entry entries[PROFILE_MAX_SYMBOLS];
+static int num_entries;
+
+// Imports that never return to their caller, or return more than once
+static const char *profile_import_skip[] = {
+  "_Unwind_",
+  "__aeabi_unwind_",
+  "__cxa_begin_cleanup",
+  "__cxa_end_cleanup",
+  "__cxa_rethrow",
+  "__cxa_throw",
+  "__gnu_Unwind_",
+  "__stack_chk_fail",
+  "_exit",
+  "_longjmp",
+  "_setjmp",
+  "abort",
+  "exit",
+  "longjmp",
+  "pthread_exit",
+  "setjmp",
+  "siglongjmp",
+  "sigsetjmp",
+};
+
+static pthread_key_t thread_key;
+static pthread_mutex_t thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static profile_thread *threads;
+
+static profile_thread *profile_thread_get(void) {
+  profile_thread *thread = pthread_getspecific(thread_key);
+  if (!thread) {
+    thread = calloc(1, sizeof(profile_thread));
+    if (!thread)
+      fatal_error("Error could not allocate profile buffer.");
+    pthread_setspecific(thread_key, thread);
+
+    pthread_mutex_lock(&thread_lock);
+    thread->next = threads;
+    threads = thread;
+    pthread_mutex_unlock(&thread_lock);
+  }
+  return thread;
+}
+
+static void profile_caller_add(profile_caller *callers, uintptr_t lr, uint32_t count) {
+  int min = 0;
+  for (int i = 0; i < PROFILE_MAX_CALLERS; i++) {
+    if (callers[i].lr == lr || callers[i].count == 0) {
+      callers[i].lr = lr;
+      callers[i].count += count;
+      return;
+    }
+    if (callers[i].count < callers[min].count)
+      min = i;
+  }
+  // Evict the least frequent caller, the report only shows the hot ones anyway
+  callers[min].lr = lr;
+  callers[min].count = count;
+}
+
+// Called from profile_thunk_enter, returns the original function to tail call into
+__attribute__((used)) static uintptr_t profile_enter(int entry, uintptr_t lr) {
+  profile_thread *thread = profile_thread_get();
+  if (thread->depth >= PROFILE_MAX_DEPTH)
+    fatal_error("Error profile call stack overflow in %s.", entries[entry].symbol);
+
+  profile_frame *frame = &thread->frames[thread->depth++];
+  frame->entry = entry;
+  frame->lr = lr;
+  frame->start = sceKernelGetProcessTimeWide();
+
+  return entries[entry].orig;
+}
+
+// Called from profile_thunk_exit, returns the caller's LR
+__attribute__((used)) static uintptr_t profile_exit(void) {
+  uint64_t end = sceKernelGetProcessTimeWide();
+  profile_thread *thread = pthread_getspecific(thread_key);
+  profile_frame *frame = &thread->frames[--thread->depth];
+  profile_stats *stats = &thread->stats[frame->entry];
+
+  stats->count++;
+  stats->time += end - frame->start;
+  profile_caller_add(stats->callers, frame->lr, 1);
+
+  return frame->lr;
+}
+
+// Instrumented functions return here instead of to their caller. Unwinding
+// through this frame (C++ exceptions, longjmp) is not supported. Only referenced
+// from the asm of profile_thunk_enter, so it has to be kept explicitly.
+__attribute__((naked, used)) static void profile_thunk_exit(void) {
+  __asm__ volatile (
+    "push {r0-r3}\n"
+    "bl profile_exit\n"
+    "mov ip, r0\n"
+    "pop {r0-r3}\n"
+    "bx ip\n"
+  );
+}
+
+// Per-symbol thunks jump here with the entry index in ip and the call arguments untouched
+__attribute__((naked)) static void profile_thunk_enter(void) {
+  __asm__ volatile (
+    "push {r0-r3, ip, lr}\n"
+    "mov r0, ip\n"
+    "mov r1, lr\n"
+    "bl profile_enter\n"
+    "str r0, [sp, #16]\n"
+    "pop {r0-r3, ip, lr}\n"
+    "movw lr, #:lower16:profile_thunk_exit\n"
+    "movt lr, #:upper16:profile_thunk_exit\n"
+    "bx ip\n"
+  );
+}
+
+static void profile_setup(so_module *mod) {
+  if (!profile_mod) {
+    pthread_key_create(&thread_key, NULL);
+    profile_mod = mod;
+  }
+}
+
+static uintptr_t profile_thunk(void) {
+  uint32_t thunk[4];
+
+  if (num_entries >= PROFILE_MAX_SYMBOLS)
+    return 0;
+
+  thunk[0] = 0xe59fc000; // LDR IP, [PC]
+  thunk[1] = 0xe59ff000; // LDR PC, [PC]
+  thunk[2] = num_entries;
+  thunk[3] = (uintptr_t)&profile_thunk_enter;
+
+  return trampoline_alloc(profile_mod, thunk, sizeof(thunk));
+}
+
+int profile_hook(so_module *mod, char **symbols, int size_symbols) {
+  int failed = 0;
+
+  profile_setup(mod);
+
+  // Thunks, trampolines and hooks all go live at once when the transaction commits
+  so_patch_begin();
+
+  for (int i = 0; i < size_symbols / sizeof(char *); i++) {
+    uintptr_t addr = so_symbol(mod, symbols[i]);
+    uintptr_t dst = addr ? profile_thunk() : 0;
+    if (!dst) {
+      debugPrintf("Profile: could not instrument %s\n", symbols[i]);
+      failed++;
+      continue;
+    }
+
+    // The trampoline has to exist before the thunk can run, so store it first
+    entries[num_entries].symbol = symbols[i];
+    entries[num_entries].orig = hook_wrap(addr, dst);
+    if (!entries[num_entries].orig) {
+      debugPrintf("Profile: could not relocate prologue of %s\n", symbols[i]);
+      failed++;
+      continue;
+    }
+
+    num_entries++;
+  }
+
+  so_patch_commit();
+
+  return failed;
+}
+
+// Used as so_module.import_hook, so that so_resolve binds imports to counting thunks
+uintptr_t profile_import(so_module *mod, const char *symbol, uintptr_t func) {
+  profile_setup(mod);
+
+  for (int i = 0; i < sizeof(profile_import_skip) / sizeof(char *); i++) {
+    if (strncmp(symbol, profile_import_skip[i], strlen(profile_import_skip[i])) == 0)
+      return func;
+  }
+
+  uintptr_t thunk = profile_thunk();
+  if (!thunk)
+    return func;
+
+  entries[num_entries].symbol = symbol;
+  entries[num_entries].orig = func;
+  num_entries++;
+
+  return thunk;
+}
+
+static profile_stats report_stats[PROFILE_MAX_SYMBOLS];
+
+static int profile_compare(const void *a, const void *b) {
+  const profile_stats *sa = &report_stats[*(const int *)a];
+  const profile_stats *sb = &report_stats[*(const int *)b];
+  if (sa->time != sb->time)
+    return sa->time < sb->time ? 1 : -1;
+  return sb->count - sa->count;
+}
+
+void profile_report(const char *path) {
+  int order[PROFILE_MAX_SYMBOLS];
+
+  // Also serializes the flush thread against the report at exit
+  pthread_mutex_lock(&thread_lock);
+
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    pthread_mutex_unlock(&thread_lock);
+    return;
+  }
+
+  memset(report_stats, 0, sizeof(report_stats));
+
+  for (profile_thread *thread = threads; thread; thread = thread->next) {
+    for (int i = 0; i < num_entries; i++) {
+      profile_stats *stats = &thread->stats[i];
+      report_stats[i].count += stats->count;
+      report_stats[i].time += stats->time;
+      for (int j = 0; j < PROFILE_MAX_CALLERS; j++) {
+        if (stats->callers[j].count)
+          profile_caller_add(report_stats[i].callers, stats->callers[j].lr, stats->callers[j].count);
+      }
+    }
+  }
+
+  for (int i = 0; i < num_entries; i++)
+    order[i] = i;
+  qsort(order, num_entries, sizeof(int), profile_compare);
+
+  fprintf(file, "%10s %12s %10s  %s\n", "calls", "total us", "us/call", "symbol");
+  for (int i = 0; i < num_entries; i++) {
+    profile_stats *stats = &report_stats[order[i]];
+    if (stats->count == 0)
+      continue;
+
+    fprintf(file, "%10u %12llu %10llu  %s\n", (unsigned int)stats->count,
+            stats->time, stats->time / stats->count, entries[order[i]].symbol);
+
+    for (int j = 0; j < PROFILE_MAX_CALLERS; j++) {
+      uintptr_t lr = stats->callers[j].lr;
+      uint32_t offset;
+      if (stats->callers[j].count == 0)
+        continue;
+      const char *caller = so_addr2sym(profile_mod, lr, &offset);
+      if (caller)
+        fprintf(file, "%35s from %s+0x%x (%u)\n", "", caller, offset, (unsigned int)stats->callers[j].count);
+      else if (lr >= profile_mod->text_base && lr < profile_mod->text_base + profile_mod->text_size)
+        fprintf(file, "%35s from +0x%08x (%u)\n", "", lr - profile_mod->text_base, (unsigned int)stats->callers[j].count);
+      else
+        fprintf(file, "%35s from  0x%08x (%u)\n", "", lr, (unsigned int)stats->callers[j].count);
+    }
+  }
+
+  fclose(file);
+
+  pthread_mutex_unlock(&thread_lock);
+}
+
+static const char *flush_path;
+static int flush_interval;
+
+static int profile_flush_thread(SceSize args, void *argp) {
+  while (1) {
+    sceKernelDelayThread(flush_interval * 1000 * 1000);
+    profile_report(flush_path);
+  }
+  return 0;
+}
+
+int profile_flush_start(const char *path, int interval) {
+  flush_path = path;
+  flush_interval = interval;
+
+  SceUID thid = sceKernelCreateThread("profile_flush_thread", profile_flush_thread, 0x10000100 + 10, 0x10000, 0, 0, NULL);
+  if (thid < 0)
+    return thid;
+
+  return sceKernelStartThread(thid, 0, NULL);
+}
@@ -0,0 +1,11 @@
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include "so_util.h"
+
+int profile_hook(so_module *mod, char **symbols, int size_symbols);
+uintptr_t profile_import(so_module *mod, const char *symbol, uintptr_t func);
+void profile_report(const char *path);
+int profile_flush_start(const char *path, int interval);
+
+#endif
@@ -0,0 +1,521 @@
+/* program_cache.c -- persistent cache of linked program binaries
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <vitasdk.h>
+#include <vitaGL.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "program_cache.h"
+#include "xxhash.h"
+
+#define PROGRAM_CACHE_MAGIC 0x43475250 // PRGC
+#define PROGRAM_CACHE_VERSION 1
+
+#define PROGRAM_CACHE_MAX_NAMES 4096
+#define PROGRAM_CACHE_REPORT_INTERVAL 32
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+} program_cache_header;
+
+// Each record is followed by size bytes of the binary, the last record of a key wins
+typedef struct {
+  uint64_t key;
+  uint32_t format;
+  uint32_t size;
+} program_cache_record;
+
+typedef struct {
+  uint64_t key;
+  uint32_t format;
+  uint32_t size;
+  uint32_t offset;
+} program_cache_entry;
+
+enum {
+  UNIFORM_FLOAT,
+  UNIFORM_INT,
+  UNIFORM_MATRIX,
+};
+
+// The last value the game set, so that it can be set again once the program is relinked
+typedef struct {
+  char *name;
+  GLint location; // in the program as it is linked now
+  int type, size, count;
+  void *data;
+} program_uniform;
+
+typedef struct {
+  uint64_t shaders[2];
+  GLuint names[2];
+  int num_shaders;
+  int linked;
+  uint64_t attribs; // sum of the hashes of all bindings, so that their order doesn't matter
+
+  // Programs linked with a dummy hand out indices into uniforms as locations, which stay valid
+  // when the compiled shader is swapped in and the real locations change
+  int virtual_uniforms;
+  program_uniform *uniforms;
+  int num_uniforms, max_uniforms;
+} program_info;
+
+static SceUID cache_fd = -1;
+static uint32_t cache_end = 0;
+
+static program_cache_entry *entries = NULL;
+static int num_entries = 0, max_entries = 0;
+static int *slots = NULL;
+static uint32_t slot_mask = 0;
+
+// GL names are small integers, shaders and programs are tracked by name
+static uint64_t shader_keys[PROGRAM_CACHE_MAX_NAMES];
+static uint8_t shader_dummies[PROGRAM_CACHE_MAX_NAMES];
+static program_info programs[PROGRAM_CACHE_MAX_NAMES];
+static GLuint current_program = 0;
+
+static uint8_t *binary_buf = NULL;
+static int binary_buf_size = 0;
+
+static int num_hits = 0, num_misses = 0, num_rejected = 0, num_uncached = 0;
+
+static int program_cache_reserve(int size) {
+  if (size <= binary_buf_size)
+    return 0;
+  uint8_t *buf = realloc(binary_buf, size);
+  if (!buf)
+    return -1;
+  binary_buf = buf;
+  binary_buf_size = size;
+  return 0;
+}
+
+static program_cache_entry *program_cache_find(uint64_t key) {
+  if (!slots)
+    return NULL;
+
+  for (uint32_t i = key & slot_mask; slots[i]; i = (i + 1) & slot_mask) {
+    if (entries[slots[i] - 1].key == key)
+      return &entries[slots[i] - 1];
+  }
+
+  return NULL;
+}
+
+static int program_cache_insert(uint64_t key, uint32_t format, uint32_t size, uint32_t offset) {
+  program_cache_entry *entry = program_cache_find(key);
+  if (entry) {
+    entry->format = format;
+    entry->size = size;
+    entry->offset = offset;
+    return 0;
+  }
+
+  if (num_entries == max_entries) {
+    int max = max_entries ? max_entries * 2 : 256;
+    program_cache_entry *e = realloc(entries, max * sizeof(program_cache_entry));
+    if (!e)
+      return -1;
+    entries = e;
+    max_entries = max;
+
+    // Keep the table at most half full, slots are rebuilt from the entries
+    int *s = calloc(max * 2, sizeof(int));
+    if (!s)
+      return -1;
+    free(slots);
+    slots = s;
+    slot_mask = max * 2 - 1;
+
+    for (int i = 0; i < num_entries; i++) {
+      uint32_t j = entries[i].key & slot_mask;
+      while (slots[j])
+        j = (j + 1) & slot_mask;
+      slots[j] = i + 1;
+    }
+  }
+
+  entry = &entries[num_entries++];
+  entry->key = key;
+  entry->format = format;
+  entry->size = size;
+  entry->offset = offset;
+
+  uint32_t j = key & slot_mask;
+  while (slots[j])
+    j = (j + 1) & slot_mask;
+  slots[j] = num_entries;
+
+  return 0;
+}
+
+// Indexes the records of an existing cache, binaries are only read when a program is linked
+int program_cache_init(const char *path) {
+  program_cache_header header;
+  program_cache_record record;
+
+  cache_fd = sceIoOpen(path, SCE_O_RDWR | SCE_O_CREAT, 0777);
+  if (cache_fd < 0)
+    return cache_fd;
+
+  if (sceIoRead(cache_fd, &header, sizeof(header)) != sizeof(header) ||
+      header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION) {
+    // Missing or from another version, start over
+    header.magic = PROGRAM_CACHE_MAGIC;
+    header.version = PROGRAM_CACHE_VERSION;
+    sceIoLseek(cache_fd, 0, SCE_SEEK_SET);
+    if (sceIoWrite(cache_fd, &header, sizeof(header)) != sizeof(header)) {
+      sceIoClose(cache_fd);
+      cache_fd = -1;
+      return -1;
+    }
+    cache_end = sizeof(header);
+    return 0;
+  }
+
+  cache_end = sizeof(header);
+  SceOff file_size = sceIoLseek(cache_fd, 0, SCE_SEEK_END);
+
+  // A record cut short by a crash is overwritten by the next one
+  while (cache_end + sizeof(record) <= file_size) {
+    sceIoLseek(cache_fd, cache_end, SCE_SEEK_SET);
+    if (sceIoRead(cache_fd, &record, sizeof(record)) != sizeof(record))
+      break;
+    if (cache_end + sizeof(record) + record.size > file_size)
+      break;
+    if (program_cache_insert(record.key, record.format, record.size, cache_end + sizeof(record)) < 0)
+      break;
+    cache_end += sizeof(record) + record.size;
+  }
+
+  debugPrintf("Program cache: %d programs in %s\n", num_entries, path);
+  return 0;
+}
+
+void program_cache_shader(GLuint shader, uint64_t hash, uint32_t length) {
+  uint64_t key[2] = { hash, length };
+  if (shader < PROGRAM_CACHE_MAX_NAMES) {
+    shader_keys[shader] = xxh64(key, sizeof(key), 0);
+    shader_dummies[shader] = 0;
+  }
+}
+
+// Marks a shader that got the dummy, until program_cache_shader is called with the compiled one
+void program_cache_dummy(GLuint shader) {
+  if (shader < PROGRAM_CACHE_MAX_NAMES)
+    shader_dummies[shader] = 1;
+}
+
+void program_cache_attach(GLuint program, GLuint shader) {
+  if (program >= PROGRAM_CACHE_MAX_NAMES)
+    return;
+  program_info *info = &programs[program];
+  if (info->num_shaders < 2) {
+    info->shaders[info->num_shaders] = shader < PROGRAM_CACHE_MAX_NAMES ? shader_keys[shader] : 0;
+    info->names[info->num_shaders] = shader;
+  }
+  info->num_shaders++;
+}
+
+void program_cache_bind_attrib(GLuint program, GLuint index, const GLchar *name) {
+  if (program >= PROGRAM_CACHE_MAX_NAMES)
+    return;
+  programs[program].attribs += xxh64(name, strlen(name), index);
+}
+
+void program_cache_forget(GLuint program) {
+  if (program >= PROGRAM_CACHE_MAX_NAMES)
+    return;
+
+  program_info *info = &programs[program];
+  for (int i = 0; i < info->num_uniforms; i++) {
+    free(info->uniforms[i].name);
+    free(info->uniforms[i].data);
+  }
+  free(info->uniforms);
+  memset(info, 0, sizeof(program_info));
+}
+
+static uint64_t program_cache_key(GLuint program) {
+  if (cache_fd < 0 || program >= PROGRAM_CACHE_MAX_NAMES)
+    return 0;
+
+  program_info *info = &programs[program];
+  if (info->num_shaders != 2 || !info->shaders[0] || !info->shaders[1])
+    return 0;
+
+  // Attach order doesn't change the program
+  uint64_t key[3];
+  key[0] = info->shaders[0] < info->shaders[1] ? info->shaders[0] : info->shaders[1];
+  key[1] = info->shaders[0] < info->shaders[1] ? info->shaders[1] : info->shaders[0];
+  key[2] = info->attribs;
+  return xxh64(key, sizeof(key), 0);
+}
+
+static int program_cache_restore(GLuint program, program_cache_entry *entry) {
+  GLint status = GL_FALSE;
+
+  if (program_cache_reserve(entry->size) < 0)
+    return -1;
+  if (sceIoLseek(cache_fd, entry->offset, SCE_SEEK_SET) != entry->offset ||
+      sceIoRead(cache_fd, binary_buf, entry->size) != entry->size)
+    return -1;
+
+  glProgramBinary(program, entry->format, binary_buf, entry->size);
+  glGetProgramiv(program, GL_LINK_STATUS, &status);
+  return status == GL_TRUE ? 0 : -1;
+}
+
+static void program_cache_store(GLuint program, uint64_t key) {
+  program_cache_record record;
+  GLint status = GL_FALSE, size = 0;
+  GLsizei length = 0;
+  GLenum format = 0;
+
+  glGetProgramiv(program, GL_LINK_STATUS, &status);
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+  if (status != GL_TRUE || size <= 0 || program_cache_reserve(size) < 0)
+    return;
+
+  glGetProgramBinary(program, size, &length, &format, binary_buf);
+  if (length <= 0)
+    return;
+
+  record.key = key;
+  record.format = format;
+  record.size = length;
+
+  sceIoLseek(cache_fd, cache_end, SCE_SEEK_SET);
+  if (sceIoWrite(cache_fd, &record, sizeof(record)) != sizeof(record) ||
+      sceIoWrite(cache_fd, binary_buf, length) != length)
+    return;
+
+  if (program_cache_insert(key, format, length, cache_end + sizeof(record)) == 0)
+    cache_end += sizeof(record) + length;
+}
+
+// Links through the cache, a binary that fails to restore is linked normally and replaced
+void program_cache_link(GLuint program) {
+  uint64_t key = program_cache_key(program);
+
+  if (program < PROGRAM_CACHE_MAX_NAMES) {
+    program_info *info = &programs[program];
+    info->linked = 1;
+    for (int k = 0; k < 2 && k < info->num_shaders; k++) {
+      if (info->names[k] < PROGRAM_CACHE_MAX_NAMES && shader_dummies[info->names[k]])
+        info->virtual_uniforms = 1;
+    }
+  }
+
+  if (!key) {
+    num_uncached++;
+    glLinkProgram(program);
+  } else {
+    program_cache_entry *entry = program_cache_find(key);
+    if (entry && program_cache_restore(program, entry) == 0) {
+      num_hits++;
+    } else {
+      if (entry)
+        num_rejected++;
+      num_misses++;
+      glLinkProgram(program);
+      program_cache_store(program, key);
+    }
+  }
+
+  // Locations change with every link
+  if (program < PROGRAM_CACHE_MAX_NAMES) {
+    program_info *info = &programs[program];
+    for (int i = 0; i < info->num_uniforms; i++)
+      info->uniforms[i].location = glGetUniformLocation(program, info->uniforms[i].name);
+  }
+
+  if ((num_hits + num_misses + num_uncached) % PROGRAM_CACHE_REPORT_INTERVAL == 0)
+    program_cache_report();
+}
+
+static void program_cache_replay(program_uniform *uniform) {
+  GLint location = uniform->location;
+  GLsizei count = uniform->count;
+
+  if (location < 0 || !uniform->data)
+    return;
+
+  switch (uniform->type) {
+    case UNIFORM_INT:
+      glUniform1i(location, *(GLint *)uniform->data);
+      break;
+    case UNIFORM_MATRIX:
+      if (uniform->size == 2)
+        glUniformMatrix2fv(location, count, GL_FALSE, uniform->data);
+      else if (uniform->size == 3)
+        glUniformMatrix3fv(location, count, GL_FALSE, uniform->data);
+      else
+        glUniformMatrix4fv(location, count, GL_FALSE, uniform->data);
+      break;
+    default:
+      if (uniform->size == 1)
+        glUniform1fv(location, count, uniform->data);
+      else if (uniform->size == 2)
+        glUniform2fv(location, count, uniform->data);
+      else if (uniform->size == 3)
+        glUniform3fv(location, count, uniform->data);
+      else
+        glUniform4fv(location, count, uniform->data);
+      break;
+  }
+}
+
+// Links again every program that was linked with the dummy in place of this shader. Linking resets
+// the uniforms, so the values the game set are set again at their new locations, samplers included.
+void program_cache_relink(GLuint shader) {
+  for (GLuint program = 1; program < PROGRAM_CACHE_MAX_NAMES; program++) {
+    program_info *info = &programs[program];
+    if (!info->linked || info->num_shaders != 2 || (info->names[0] != shader && info->names[1] != shader))
+      continue;
+
+    for (int k = 0; k < 2; k++) {
+      if (info->names[k] < PROGRAM_CACHE_MAX_NAMES)
+        info->shaders[k] = shader_keys[info->names[k]];
+    }
+    program_cache_link(program);
+
+    if (info->num_uniforms > 0) {
+      glUseProgram(program);
+      for (int i = 0; i < info->num_uniforms; i++)
+        program_cache_replay(&info->uniforms[i]);
+      glUseProgram(current_program);
+    }
+  }
+}
+
+void program_cache_use(GLuint program) {
+  current_program = program;
+  glUseProgram(program);
+}
+
+GLint program_cache_uniform_location(GLuint program, const GLchar *name) {
+  if (program >= PROGRAM_CACHE_MAX_NAMES || !programs[program].virtual_uniforms)
+    return glGetUniformLocation(program, name);
+
+  program_info *info = &programs[program];
+  for (int i = 0; i < info->num_uniforms; i++) {
+    if (strcmp(info->uniforms[i].name, name) == 0)
+      return i;
+  }
+
+  if (info->num_uniforms == info->max_uniforms) {
+    int max = info->max_uniforms ? info->max_uniforms * 2 : 16;
+    program_uniform *uniforms = realloc(info->uniforms, max * sizeof(program_uniform));
+    if (!uniforms)
+      return -1;
+    info->uniforms = uniforms;
+    info->max_uniforms = max;
+  }
+
+  program_uniform *uniform = &info->uniforms[info->num_uniforms];
+  memset(uniform, 0, sizeof(program_uniform));
+  uniform->name = strdup(name);
+  if (!uniform->name)
+    return -1;
+  uniform->location = glGetUniformLocation(program, name);
+  return info->num_uniforms++;
+}
+
+// Keeps the value for programs with virtual locations and turns the location into the real one.
+// Returns 0 if there is nothing to set in the program as it is linked now.
+static int program_cache_uniform(GLint *location, int type, int size, int count, const void *data) {
+  if (current_program >= PROGRAM_CACHE_MAX_NAMES || !programs[current_program].virtual_uniforms)
+    return 1;
+
+  program_info *info = &programs[current_program];
+  if (*location < 0 || *location >= info->num_uniforms)
+    return 0;
+
+  program_uniform *uniform = &info->uniforms[*location];
+  int data_size = count * (type == UNIFORM_MATRIX ? size * size : size) * 4;
+  if (!uniform->data || uniform->type != type || uniform->size != size || uniform->count != count) {
+    free(uniform->data);
+    uniform->data = malloc(data_size);
+    uniform->type = type;
+    uniform->size = size;
+    uniform->count = count;
+  }
+  if (uniform->data)
+    memcpy(uniform->data, data, data_size);
+
+  *location = uniform->location;
+  return *location >= 0;
+}
+
+void program_cache_uniform1i(GLint location, GLint v0) {
+  if (program_cache_uniform(&location, UNIFORM_INT, 1, 1, &v0))
+    glUniform1i(location, v0);
+}
+
+void program_cache_uniform1f(GLint location, GLfloat v0) {
+  if (program_cache_uniform(&location, UNIFORM_FLOAT, 1, 1, &v0))
+    glUniform1f(location, v0);
+}
+
+void program_cache_uniform2f(GLint location, GLfloat v0, GLfloat v1) {
+  GLfloat v[2] = { v0, v1 };
+  if (program_cache_uniform(&location, UNIFORM_FLOAT, 2, 1, v))
+    glUniform2f(location, v0, v1);
+}
+
+void program_cache_uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+  GLfloat v[3] = { v0, v1, v2 };
+  if (program_cache_uniform(&location, UNIFORM_FLOAT, 3, 1, v))
+    glUniform3f(location, v0, v1, v2);
+}
+
+void program_cache_uniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+  GLfloat v[4] = { v0, v1, v2, v3 };
+  if (program_cache_uniform(&location, UNIFORM_FLOAT, 4, 1, v))
+    glUniform4f(location, v0, v1, v2, v3);
+}
+
+void program_cache_uniform3fv(GLint location, GLsizei count, const GLfloat *value) {
+  if (program_cache_uniform(&location, UNIFORM_FLOAT, 3, count, value))
+    glUniform3fv(location, count, value);
+}
+
+void program_cache_uniform4fv(GLint location, GLsizei count, const GLfloat *value) {
+  if (program_cache_uniform(&location, UNIFORM_FLOAT, 4, count, value))
+    glUniform4fv(location, count, value);
+}
+
+void program_cache_uniform_matrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+  if (program_cache_uniform(&location, UNIFORM_MATRIX, 2, count, value))
+    glUniformMatrix2fv(location, count, transpose, value);
+}
+
+void program_cache_uniform_matrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+  if (program_cache_uniform(&location, UNIFORM_MATRIX, 3, count, value))
+    glUniformMatrix3fv(location, count, transpose, value);
+}
+
+void program_cache_uniform_matrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+  if (program_cache_uniform(&location, UNIFORM_MATRIX, 4, count, value))
+    glUniformMatrix4fv(location, count, transpose, value);
+}
+
+void program_cache_report(void) {
+  debugPrintf("Program cache: %d hits, %d misses, %d rejected, %d uncached, %d programs stored\n",
+              num_hits, num_misses, num_rejected, num_uncached, num_entries);
+}
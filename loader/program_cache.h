@@ -0,0 +1,29 @@
+#ifndef __PROGRAM_CACHE_H__
+#define __PROGRAM_CACHE_H__
+
+#include <stdint.h>
+#include <vitaGL.h>
+
+int program_cache_init(const char *path);
+void program_cache_shader(GLuint shader, uint64_t hash, uint32_t length);
+void program_cache_dummy(GLuint shader);
+void program_cache_attach(GLuint program, GLuint shader);
+void program_cache_bind_attrib(GLuint program, GLuint index, const GLchar *name);
+void program_cache_forget(GLuint program);
+void program_cache_link(GLuint program);
+void program_cache_relink(GLuint shader);
+void program_cache_use(GLuint program);
+GLint program_cache_uniform_location(GLuint program, const GLchar *name);
+void program_cache_uniform1i(GLint location, GLint v0);
+void program_cache_uniform1f(GLint location, GLfloat v0);
+void program_cache_uniform2f(GLint location, GLfloat v0, GLfloat v1);
+void program_cache_uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+void program_cache_uniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+void program_cache_uniform3fv(GLint location, GLsizei count, const GLfloat *value);
+void program_cache_uniform4fv(GLint location, GLsizei count, const GLfloat *value);
+void program_cache_uniform_matrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value);
+void program_cache_uniform_matrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value);
+void program_cache_uniform_matrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value);
+void program_cache_report(void);
+
+#endif
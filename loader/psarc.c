@@ -0,0 +1,459 @@
+/* psarc.c -- in-memory index of content-addressed files in a PSARC
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <vitasdk.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zlib.h>
+
+#include "main.h"
+#include "psarc.h"
+
+#define PSARC_MAGIC 0x50534152 // PSAR
+#define PSARC_HEADER_SIZE 32
+#define PSARC_ENTRY_SIZE 30
+#define PSARC_FLAG_ENCRYPTED 4
+
+typedef struct {
+  uint64_t hash;
+  uint32_t length; // of the shader source, guards against hash collisions
+  uint32_t block;
+  uint32_t size;
+  uint64_t offset;
+  uint8_t *data; // published by the prewarm thread
+  int seen;
+} psarc_entry;
+
+static SceUID psarc_fd = -1;
+static char psarc_path[256];
+static uint32_t block_size;
+static int compressed;
+
+// Compressed size of every block, 0 stands for a full block
+static uint32_t *blocks = NULL;
+static int num_blocks = 0;
+
+static psarc_entry *entries = NULL;
+static int num_entries = 0;
+
+// Names are already hashes, so the low bits index the table directly
+static int *slots = NULL;
+static uint32_t slot_mask = 0;
+
+static uint8_t *read_buf = NULL, *block_buf = NULL;
+static int read_buf_size = 0;
+
+static SceUID prewarm_thid = -1;
+static int *prewarm_order = NULL;
+static int num_prewarm = 0, prewarm_budget = 0;
+static volatile int prewarm_stop = 0;
+
+// Every shader used for the first time is appended, so later sessions warm it early
+static SceUID manifest_fd = -1;
+
+static int num_warm_reads = 0, num_cold_reads = 0;
+
+static uint32_t be_read(const uint8_t *p, int n) {
+  uint32_t v = 0;
+  for (int i = 0; i < n; i++)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+static int psarc_read(SceUID fd, void *buf, uint32_t size, uint64_t offset) {
+  if (sceIoLseek(fd, offset, SCE_SEEK_SET) != offset)
+    return -1;
+  if (sceIoRead(fd, buf, size) != size)
+    return -1;
+  return 0;
+}
+
+// Unpacks a file block by block into dst, scratch holds one compressed block
+static int psarc_extract(SceUID fd, uint8_t *scratch, psarc_entry *entry, uint8_t *dst) {
+  uint64_t offset = entry->offset;
+  uint32_t left = entry->size;
+
+  for (uint32_t b = entry->block; left > 0; b++) {
+    if (b >= num_blocks)
+      return -1;
+
+    uint32_t out = left < block_size ? left : block_size;
+    uint32_t in = blocks[b] ? blocks[b] : block_size;
+
+    // Blocks that don't shrink are stored as is
+    if (in == out) {
+      if (psarc_read(fd, dst, out, offset) < 0)
+        return -1;
+    } else {
+      if (!compressed || psarc_read(fd, scratch, in, offset) < 0)
+        return -1;
+      uLongf len = out;
+      if (uncompress(dst, &len, scratch, in) != Z_OK || len != out)
+        return -1;
+    }
+
+    offset += in;
+    dst += out;
+    left -= out;
+  }
+
+  return 0;
+}
+
+static int psarc_parse_hex(const char *p, int digits, uint64_t *value) {
+  uint64_t v = 0;
+  for (int i = 0; i < digits; i++) {
+    char c = p[i];
+    if (c >= '0' && c <= '9')
+      v = (v << 4) | (c - '0');
+    else if (c >= 'a' && c <= 'f')
+      v = (v << 4) | (c - 'a' + 10);
+    else if (c >= 'A' && c <= 'F')
+      v = (v << 4) | (c - 'A' + 10);
+    else
+      return -1;
+  }
+  *value = v;
+  return 0;
+}
+
+// Accepts names ending in <16 hex digits hash>_<8 hex digits length>.cg.gxp, or legacy
+// <8 hex digits SHA1 word>.cg.gxp names, which are keyed with a length of 0
+static int psarc_name_key(const char *name, int len, uint64_t *hash, uint32_t *length) {
+  const char *suffix = ".cg.gxp";
+  int suffix_len = strlen(suffix);
+  uint64_t v;
+
+  if (len < 8 + suffix_len || strncmp(name + len - suffix_len, suffix, suffix_len) != 0)
+    return -1;
+
+  const char *p = name + len - suffix_len - 25;
+  if (len >= 25 + suffix_len && (p == name || p[-1] == '/') && p[16] == '_') {
+    if (psarc_parse_hex(p, 16, hash) < 0 || psarc_parse_hex(p + 17, 8, &v) < 0)
+      return -1;
+    *length = v;
+    return 0;
+  }
+
+  p = name + len - suffix_len - 8;
+  if ((p > name && p[-1] != '/') || psarc_parse_hex(p, 8, hash) < 0)
+    return -1;
+  *length = 0;
+  return 0;
+}
+
+static psarc_entry *psarc_find(uint64_t hash, uint32_t length) {
+  int collision = 0;
+
+  if (!slots)
+    return NULL;
+
+  for (uint32_t i = hash & slot_mask; slots[i]; i = (i + 1) & slot_mask) {
+    psarc_entry *entry = &entries[slots[i] - 1];
+    if (entry->hash == hash) {
+      if (entry->length == length)
+        return entry;
+      collision = 1;
+    }
+  }
+
+  if (collision)
+    debugPrintf("PSARC: hash collision on %016llx with length %08x\n", hash, length);
+
+  return NULL;
+}
+
+static int psarc_reserve(int size) {
+  if (size <= read_buf_size)
+    return 0;
+  uint8_t *buf = realloc(read_buf, size);
+  if (!buf)
+    return -1;
+  read_buf = buf;
+  read_buf_size = size;
+  return 0;
+}
+
+// Reads the table of contents and the manifest once, file lookups don't touch the filesystem after that
+int psarc_index_load(const char *path) {
+  uint8_t header[PSARC_HEADER_SIZE];
+  uint8_t *toc = NULL;
+  char *manifest = NULL;
+  psarc_entry *toc_entries = NULL;
+  int res = -1;
+
+  psarc_index_close();
+
+  psarc_fd = sceIoOpen(path, SCE_O_RDONLY, 0);
+  if (psarc_fd < 0)
+    return psarc_fd;
+
+  snprintf(psarc_path, sizeof(psarc_path), "%s", path);
+
+  if (psarc_read(psarc_fd, header, sizeof(header), 0) < 0 || be_read(header, 4) != PSARC_MAGIC)
+    goto err_free;
+
+  uint32_t toc_size = be_read(header + 12, 4);
+  uint32_t entry_size = be_read(header + 16, 4);
+  uint32_t num_toc = be_read(header + 20, 4);
+  uint32_t flags = be_read(header + 28, 4);
+  block_size = be_read(header + 24, 4);
+  compressed = memcmp(header + 8, "zlib", 4) == 0;
+
+  if ((flags & PSARC_FLAG_ENCRYPTED) || entry_size < PSARC_ENTRY_SIZE || num_toc == 0 || block_size == 0 ||
+      toc_size < PSARC_HEADER_SIZE + num_toc * entry_size)
+    goto err_free;
+
+  toc = malloc(toc_size - PSARC_HEADER_SIZE);
+  toc_entries = calloc(num_toc, sizeof(psarc_entry));
+  block_buf = malloc(block_size);
+  if (!toc || !toc_entries || !block_buf)
+    goto err_free;
+
+  if (psarc_read(psarc_fd, toc, toc_size - PSARC_HEADER_SIZE, PSARC_HEADER_SIZE) < 0)
+    goto err_free;
+
+  for (int i = 0; i < num_toc; i++) {
+    uint8_t *e = toc + i * entry_size;
+    toc_entries[i].block = be_read(e + 16, 4);
+    toc_entries[i].size = be_read(e + 21, 4); // the upper byte of the 40-bit size is always 0 here
+    toc_entries[i].offset = ((uint64_t)e[25] << 32) | be_read(e + 26, 4);
+  }
+
+  // Block sizes are stored in as few bytes as the block size needs
+  int width = block_size <= 0x10000 ? 2 : (block_size <= 0x1000000 ? 3 : 4);
+  uint8_t *table = toc + num_toc * entry_size;
+  num_blocks = (toc_size - PSARC_HEADER_SIZE - num_toc * entry_size) / width;
+  blocks = malloc(num_blocks * sizeof(uint32_t));
+  if (!blocks)
+    goto err_free;
+  for (int i = 0; i < num_blocks; i++)
+    blocks[i] = be_read(table + i * width, width);
+
+  // Entry 0 is the manifest, its lines name the other entries in order
+  manifest = malloc(toc_entries[0].size + 1);
+  if (!manifest || psarc_extract(psarc_fd, block_buf, &toc_entries[0], (uint8_t *)manifest) < 0)
+    goto err_free;
+  manifest[toc_entries[0].size] = '\0';
+
+  entries = malloc(num_toc * sizeof(psarc_entry));
+  if (!entries)
+    goto err_free;
+
+  char *name = manifest;
+  for (int i = 1; i < num_toc && name; i++) {
+    char *next = strchr(name, '\n');
+    int len = next ? next - name : strlen(name);
+    if (len > 0 && name[len - 1] == '\r')
+      len--;
+    if (psarc_name_key(name, len, &toc_entries[i].hash, &toc_entries[i].length) == 0)
+      entries[num_entries++] = toc_entries[i];
+    name = next ? next + 1 : NULL;
+  }
+
+  // Keep the table at most half full
+  uint32_t num_slots = 16;
+  while (num_slots < num_entries * 2)
+    num_slots *= 2;
+  slots = calloc(num_slots, sizeof(int));
+  if (!slots)
+    goto err_free;
+  slot_mask = num_slots - 1;
+
+  for (int i = 0; i < num_entries; i++) {
+    uint32_t j = entries[i].hash & slot_mask;
+    while (slots[j])
+      j = (j + 1) & slot_mask;
+    slots[j] = i + 1;
+  }
+
+  debugPrintf("PSARC: indexed %d of %d files in %s\n", num_entries, num_toc - 1, path);
+
+  // Nothing to look up, leave shaders to the FIOS mount
+  if (num_entries > 0)
+    res = 0;
+
+err_free:
+  free(manifest);
+  free(toc_entries);
+  free(toc);
+  if (res < 0)
+    psarc_index_close();
+  return res;
+}
+
+int psarc_index_loaded(void) {
+  return slots != NULL && num_entries > 0;
+}
+
+static int prewarm_thread(SceSize args, void *argp) {
+  SceUInt64 start = sceKernelGetProcessTimeWide();
+  int num_warm = 0, total = 0;
+
+  // A handle and scratch buffer of its own, the game thread keeps reading cold shaders meanwhile
+  SceUID fd = sceIoOpen(psarc_path, SCE_O_RDONLY, 0);
+  uint8_t *scratch = malloc(block_size);
+  if (fd < 0 || !scratch)
+    goto exit;
+
+  for (int i = 0; i < num_prewarm && !prewarm_stop; i++) {
+    psarc_entry *entry = &entries[prewarm_order[i]];
+    if (total + entry->size > prewarm_budget)
+      break;
+
+    uint8_t *data = malloc(entry->size);
+    if (!data)
+      break;
+    if (psarc_extract(fd, scratch, entry, data) < 0) {
+      free(data);
+      continue;
+    }
+
+    __atomic_store_n(&entry->data, data, __ATOMIC_RELEASE);
+    total += entry->size;
+    num_warm++;
+  }
+
+  debugPrintf("PSARC: prewarmed %d shaders, %d KB in %llu us\n",
+              num_warm, total / 1024, sceKernelGetProcessTimeWide() - start);
+
+exit:
+  free(scratch);
+  if (fd >= 0)
+    sceIoClose(fd);
+  return 0;
+}
+
+// Shaders from the manifest go first, in the order earlier sessions first used them, then the rest of the archive
+int psarc_prewarm_start(const char *manifest_path, int budget) {
+  if (!slots || prewarm_thid >= 0)
+    return -1;
+
+  prewarm_order = malloc(num_entries * sizeof(int));
+  if (!prewarm_order)
+    return -1;
+  num_prewarm = 0;
+  prewarm_budget = budget;
+  prewarm_stop = 0;
+
+  SceUID fd = sceIoOpen(manifest_path, SCE_O_RDONLY, 0);
+  if (fd >= 0) {
+    int size = sceIoLseek(fd, 0, SCE_SEEK_END);
+    char *manifest = size > 0 ? malloc(size + 1) : NULL;
+    if (manifest && psarc_read(fd, manifest, size, 0) == 0) {
+      manifest[size] = '\0';
+
+      // One <hash>_<length> per line
+      char *line = manifest;
+      while (line) {
+        char *next = strchr(line, '\n');
+        int len = next ? next - line : strlen(line);
+        uint64_t hash, length;
+        if (len >= 25 && line[16] == '_' && psarc_parse_hex(line, 16, &hash) == 0 &&
+            psarc_parse_hex(line + 17, 8, &length) == 0) {
+          psarc_entry *entry = psarc_find(hash, length);
+          if (entry && !entry->seen) {
+            entry->seen = 1;
+            prewarm_order[num_prewarm++] = entry - entries;
+          }
+        }
+        line = next ? next + 1 : NULL;
+      }
+    }
+    free(manifest);
+    sceIoClose(fd);
+  }
+
+  for (int i = 0; i < num_entries; i++) {
+    if (!entries[i].seen)
+      prewarm_order[num_prewarm++] = i;
+  }
+
+  manifest_fd = sceIoOpen(manifest_path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_APPEND, 0777);
+
+  // Core 2 is left alone by the game thread on core 0 and its workers
+  prewarm_thid = sceKernelCreateThread("shader_prewarm", prewarm_thread, 0x10000100 + 10, 0x4000, 0, 0x40000, NULL);
+  if (prewarm_thid < 0)
+    return prewarm_thid;
+
+  return sceKernelStartThread(prewarm_thid, 0, NULL);
+}
+
+// Returns a buffer that stays valid until the next read, or NULL if there is no such file
+void *psarc_index_read(uint64_t hash, uint32_t length, int *size) {
+  psarc_entry *entry = psarc_find(hash, length);
+  if (!entry)
+    return NULL;
+
+  if (!entry->seen && manifest_fd >= 0) {
+    char line[32];
+    snprintf(line, sizeof(line), "%016llx_%08x\n", hash, length);
+    sceIoWrite(manifest_fd, line, strlen(line));
+  }
+  entry->seen = 1;
+
+  *size = entry->size;
+
+  uint8_t *data = __atomic_load_n(&entry->data, __ATOMIC_ACQUIRE);
+  if (data) {
+    num_warm_reads++;
+    return data;
+  }
+
+  if (psarc_reserve(entry->size) < 0 || psarc_extract(psarc_fd, block_buf, entry, read_buf) < 0) {
+    debugPrintf("PSARC: could not read %016llx\n", hash);
+    return NULL;
+  }
+
+  num_cold_reads++;
+  return read_buf;
+}
+
+void psarc_index_close(void) {
+  if (prewarm_thid >= 0) {
+    prewarm_stop = 1;
+    sceKernelWaitThreadEnd(prewarm_thid, NULL, NULL);
+    sceKernelDeleteThread(prewarm_thid);
+    prewarm_thid = -1;
+    debugPrintf("PSARC: %d warm reads, %d cold reads\n", num_warm_reads, num_cold_reads);
+  }
+
+  if (manifest_fd >= 0)
+    sceIoClose(manifest_fd);
+  manifest_fd = -1;
+
+  if (psarc_fd >= 0)
+    sceIoClose(psarc_fd);
+  psarc_fd = -1;
+
+  for (int i = 0; i < num_entries; i++)
+    free(entries[i].data);
+
+  free(prewarm_order);
+  free(slots);
+  free(entries);
+  free(blocks);
+  free(block_buf);
+  free(read_buf);
+  prewarm_order = NULL;
+  slots = NULL;
+  entries = NULL;
+  blocks = NULL;
+  block_buf = NULL;
+  read_buf = NULL;
+  slot_mask = 0;
+  num_entries = 0;
+  num_prewarm = 0;
+  num_blocks = 0;
+  read_buf_size = 0;
+  num_warm_reads = 0;
+  num_cold_reads = 0;
+}
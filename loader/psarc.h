@@ -0,0 +1,12 @@
+#ifndef __PSARC_H__
+#define __PSARC_H__
+
+#include <stdint.h>
+
+int psarc_index_load(const char *path);
+int psarc_index_loaded(void);
+int psarc_prewarm_start(const char *manifest_path, int budget);
+void *psarc_index_read(uint64_t hash, uint32_t length, int *size);
+void psarc_index_close(void);
+
+#endif
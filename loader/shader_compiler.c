@@ -0,0 +1,343 @@
+/* shader_compiler.c -- compile missing shaders in the background
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <vitasdk.h>
+#ifdef __vita__
+#include <vitaGL.h>
+#include <vitashark.h>
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "glsl_translate.h"
+#include "shader_compiler.h"
+
+#define SHADER_COMPILER_MAX 2048
+#define SHADER_COMPILER_SLOTS (SHADER_COMPILER_MAX * 2)
+
+enum {
+  SHADER_PENDING,
+  SHADER_READY,
+  SHADER_FAILED,
+};
+
+typedef struct {
+  uint64_t hash;
+  uint32_t length;
+  uint32_t size; // of the GXP once it is ready
+  int state;
+} shader_overlay;
+
+typedef struct shader_job {
+  struct shader_job *next;
+  shader_overlay *overlay;
+  int fragment;
+  char source[];
+} shader_job;
+
+static shader_compiler *backend = NULL;
+static char overlay_dir[256];
+
+// Shaders in the overlay directory and the ones queued this session, under the lock
+static shader_overlay overlays[SHADER_COMPILER_MAX];
+static int num_overlays = 0;
+static int slots[SHADER_COMPILER_SLOTS];
+
+// Compiled this session and not yet picked up by shader_compiler_ready, each overlay is added once
+static shader_overlay *done[SHADER_COMPILER_MAX];
+static int num_done = 0, done_pos = 0;
+
+static shader_job *queue_head = NULL, *queue_tail = NULL;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static int stopping = 0;
+static SceUID compiler_thid = -1;
+
+static char *read_buf = NULL;
+static int read_buf_size = 0;
+
+static shader_overlay *overlay_find(uint64_t hash, uint32_t length) {
+  for (uint32_t i = hash & (SHADER_COMPILER_SLOTS - 1); slots[i]; i = (i + 1) & (SHADER_COMPILER_SLOTS - 1)) {
+    shader_overlay *overlay = &overlays[slots[i] - 1];
+    if (overlay->hash == hash && overlay->length == length)
+      return overlay;
+  }
+  return NULL;
+}
+
+static shader_overlay *overlay_add(uint64_t hash, uint32_t length, uint32_t size, int state) {
+  if (num_overlays == SHADER_COMPILER_MAX)
+    return NULL;
+
+  shader_overlay *overlay = &overlays[num_overlays++];
+  overlay->hash = hash;
+  overlay->length = length;
+  overlay->size = size;
+  overlay->state = state;
+
+  uint32_t i = hash & (SHADER_COMPILER_SLOTS - 1);
+  while (slots[i])
+    i = (i + 1) & (SHADER_COMPILER_SLOTS - 1);
+  slots[i] = num_overlays;
+
+  return overlay;
+}
+
+static void overlay_path(char *path, int size, shader_overlay *overlay, const char *ext) {
+  snprintf(path, size, "%s/%016llx_%08x.%s", overlay_dir, (unsigned long long)overlay->hash, overlay->length, ext);
+}
+
+// Written to a temporary file first, so that a crash never leaves a truncated GXP behind
+static int overlay_write(shader_overlay *overlay, const void *data, int size) {
+  char tmp_path[512], path[512];
+  overlay_path(tmp_path, sizeof(tmp_path), overlay, "tmp");
+  overlay_path(path, sizeof(path), overlay, "cg.gxp");
+
+  SceUID fd = sceIoOpen(tmp_path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0777);
+  if (fd < 0)
+    return fd;
+  int written = sceIoWrite(fd, data, size);
+  sceIoClose(fd);
+
+  if (written != size || sceIoRename(tmp_path, path) < 0) {
+    sceIoRemove(tmp_path);
+    return -1;
+  }
+
+  return 0;
+}
+
+static int compiler_thread(SceSize args, void *argp) {
+  while (1) {
+    pthread_mutex_lock(&lock);
+    while (!queue_head && !stopping)
+      pthread_cond_wait(&cond, &lock);
+    if (stopping) {
+      pthread_mutex_unlock(&lock);
+      break;
+    }
+    shader_job *job = queue_head;
+    queue_head = job->next;
+    if (!queue_head)
+      queue_tail = NULL;
+    pthread_mutex_unlock(&lock);
+
+    SceUInt64 start = sceKernelGetProcessTimeWide();
+    int length = job->overlay->length, size = 0;
+    char *translated = NULL;
+    const char *source = job->source;
+    if (backend->translate)
+      source = translated = backend->translate(job->source, length, job->fragment, &length);
+
+    void *gxp = source ? backend->compile(source, length, job->fragment, &size) : NULL;
+    int state = gxp && overlay_write(job->overlay, gxp, size) == 0 ? SHADER_READY : SHADER_FAILED;
+
+    debugPrintf("Shader compiler: %016llx_%08x %s in %llu us\n", (unsigned long long)job->overlay->hash, job->overlay->length,
+                state == SHADER_READY ? "compiled" : "failed", sceKernelGetProcessTimeWide() - start);
+
+    pthread_mutex_lock(&lock);
+    job->overlay->size = size;
+    job->overlay->state = state;
+    if (state == SHADER_READY)
+      done[num_done++] = job->overlay;
+    pthread_mutex_unlock(&lock);
+
+    free(translated);
+    free(gxp);
+    free(job);
+  }
+
+  return 0;
+}
+
+// Indexes what earlier sessions compiled and starts the worker on core 2
+int shader_compiler_start(shader_compiler *compiler, const char *path) {
+  SceIoDirent dirent;
+
+  if (compiler_thid >= 0)
+    return -1;
+
+  stopping = 0;
+  snprintf(overlay_dir, sizeof(overlay_dir), "%s", path);
+  sceIoMkdir(overlay_dir, 0777);
+
+  SceUID dfd = sceIoDopen(overlay_dir);
+  if (dfd >= 0) {
+    while (sceIoDread(dfd, &dirent) > 0) {
+      unsigned long long hash;
+      unsigned int length;
+      char ext[8];
+      if (sscanf(dirent.d_name, "%16llx_%8x.%7s", &hash, &length, ext) == 3 && strcmp(ext, "cg.gxp") == 0 &&
+          dirent.d_stat.st_size > 0 && !overlay_find(hash, length))
+        overlay_add(hash, length, dirent.d_stat.st_size, SHADER_READY);
+    }
+    sceIoDclose(dfd);
+  }
+
+  if (!compiler || (compiler->init && compiler->init() < 0)) {
+    debugPrintf("Shader compiler: %s is not available, %d compiled shaders\n",
+                compiler ? compiler->name : "none", num_overlays);
+    return -1;
+  }
+  backend = compiler;
+
+  compiler_thid = sceKernelCreateThread("shader_compiler", compiler_thread, 0x10000100 + 10, 0x40000, 0, 0x40000, NULL);
+  if (compiler_thid < 0)
+    return compiler_thid;
+
+  debugPrintf("Shader compiler: using %s, %d compiled shaders\n", compiler->name, num_overlays);
+  return sceKernelStartThread(compiler_thid, 0, NULL);
+}
+
+// Returns a compiled shader, valid until the next lookup, or NULL if it isn't ready. Only shaders that
+// are ready in the index touch the filesystem, and their size is known, so that costs a single read.
+void *shader_compiler_lookup(uint64_t hash, uint32_t length, int *size) {
+  char path[512];
+
+  pthread_mutex_lock(&lock);
+  shader_overlay *overlay = overlay_find(hash, length);
+  int ready = overlay && overlay->state == SHADER_READY;
+  *size = ready ? overlay->size : 0;
+  pthread_mutex_unlock(&lock);
+
+  if (!ready)
+    return NULL;
+
+  overlay_path(path, sizeof(path), overlay, "cg.gxp");
+  SceUID fd = sceIoOpen(path, SCE_O_RDONLY, 0);
+  if (fd < 0)
+    return NULL;
+
+  if (*size > read_buf_size) {
+    free(read_buf);
+    read_buf = malloc(*size);
+    read_buf_size = read_buf ? *size : 0;
+  }
+
+  int res = read_buf ? sceIoRead(fd, read_buf, *size) : -1;
+  sceIoClose(fd);
+
+  return res == *size ? read_buf : NULL;
+}
+
+// Each source is compiled at most once per session, failed ones are retried in the next one
+int shader_compiler_queue(uint64_t hash, uint32_t length, const char *source, int fragment) {
+  if (compiler_thid < 0)
+    return -1;
+
+  shader_job *job = malloc(sizeof(shader_job) + length + 1);
+  if (!job)
+    return -1;
+
+  pthread_mutex_lock(&lock);
+
+  if (overlay_find(hash, length) || !(job->overlay = overlay_add(hash, length, 0, SHADER_PENDING))) {
+    pthread_mutex_unlock(&lock);
+    free(job);
+    return -1;
+  }
+
+  job->next = NULL;
+  job->fragment = fragment;
+  memcpy(job->source, source, length);
+  job->source[length] = '\0';
+
+  if (queue_tail)
+    queue_tail->next = job;
+  else
+    queue_head = job;
+  queue_tail = job;
+
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&lock);
+
+  return 0;
+}
+
+// Reports the shaders compiled since the last call one at a time, so that the GL thread can swap them
+// in for the dummies. Returns 0 once there are none left.
+int shader_compiler_ready(uint64_t *hash, uint32_t *length) {
+  int res = 0;
+
+  pthread_mutex_lock(&lock);
+  if (done_pos < num_done) {
+    *hash = done[done_pos]->hash;
+    *length = done[done_pos]->length;
+    done_pos++;
+    res = 1;
+  }
+  pthread_mutex_unlock(&lock);
+
+  return res;
+}
+
+void shader_compiler_stop(void) {
+  if (compiler_thid < 0)
+    return;
+
+  pthread_mutex_lock(&lock);
+  stopping = 1;
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&lock);
+
+  sceKernelWaitThreadEnd(compiler_thid, NULL, NULL);
+  sceKernelDeleteThread(compiler_thid);
+  compiler_thid = -1;
+
+  while (queue_head) {
+    shader_job *job = queue_head;
+    queue_head = job->next;
+    free(job);
+  }
+  queue_tail = NULL;
+
+  if (backend->term)
+    backend->term();
+  backend = NULL;
+}
+
+#ifdef __vita__
+// libshacccg through the vitashark instance that vglInitExtended brings up, which vitaGL also ends.
+// The game only reaches the compiler through glShaderSource and glCompileShader, both of which are
+// hooked, and it has no fixed function entry points, so the worker is the only caller and compiles
+// never overlap.
+static int shacccg_init(void) {
+  return vglHasRuntimeShaderCompiler() ? 0 : -1;
+}
+
+static void *shacccg_compile(const char *source, int length, int fragment, int *size) {
+  uint32_t out_size = length; // source length in, GXP size out
+  const SceGxmProgram *program = shark_compile_shader(source, &out_size,
+                                                      fragment ? SHARK_FRAGMENT_SHADER : SHARK_VERTEX_SHADER);
+  void *gxp = NULL;
+
+  if (program && out_size > 0) {
+    gxp = malloc(out_size);
+    if (gxp) {
+      memcpy(gxp, program, out_size);
+      *size = out_size;
+    }
+  }
+
+  shark_clear_output();
+  return gxp;
+}
+
+// libshacccg only takes Cg, which vitaGL would translate to when it compiles shaders itself
+shader_compiler shader_compiler_shacccg = {
+  "libshacccg",
+  shacccg_init,
+  glsl_translate,
+  shacccg_compile,
+  NULL,
+};
+#endif
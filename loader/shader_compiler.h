@@ -0,0 +1,24 @@
+#ifndef __SHADER_COMPILER_H__
+#define __SHADER_COMPILER_H__
+
+#include <stdint.h>
+
+// A compiler turns a shader source into a GXP that the caller frees with free(). Sources are passed
+// through translate first if the compiler doesn't take GLSL.
+typedef struct {
+  const char *name;
+  int (* init)(void);
+  char *(* translate)(const char *source, int length, int fragment, int *out_length);
+  void *(* compile)(const char *source, int length, int fragment, int *size);
+  void (* term)(void);
+} shader_compiler;
+
+extern shader_compiler shader_compiler_shacccg;
+
+int shader_compiler_start(shader_compiler *compiler, const char *overlay_path);
+void *shader_compiler_lookup(uint64_t hash, uint32_t length, int *size);
+int shader_compiler_queue(uint64_t hash, uint32_t length, const char *source, int fragment);
+int shader_compiler_ready(uint64_t *hash, uint32_t *length);
+void shader_compiler_stop(void);
+
+#endif
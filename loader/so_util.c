@@ -9,100 +9,828 @@
 #include <vitasdk.h>
 #include <kubridge.h>
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <zlib.h>
+
 #include "main.h"
 #include "dialog.h"
 #include "so_util.h"
+#include "trampoline.h"
+#include "xxhash.h"
+
+#define SO_MAX_MODULES 32
+
+#define SO_READER_CHUNK (256 * 1024)
+
+#define SO_PATCH_LINE 32 // L1 line size of the Cortex-A9
+
+#define SO_STAGE_PAGE 4096
+
+#define ZIP_EOCD_MAGIC 0x06054b50
+#define ZIP_CDIR_MAGIC 0x02014b50
+#define ZIP_LOCAL_MAGIC 0x04034b50
+#define ZIP_EOCD_SIZE 22
+#define ZIP_CDIR_SIZE 46
+#define ZIP_LOCAL_SIZE 30
+#define ZIP_MAX_COMMENT 0xffff
+
+#define SO_CACHE_MAGIC 0x4B4E4C50 // PLNK
+#define SO_CACHE_VERSION 3
+
+#define SO_RELR_MAGIC 0x524C4552 // RELR
+#define SO_RELR_VERSION 3
 
-#ifndef SCE_KERNEL_MEMBLOCK_TYPE_USER_RX
-#define SCE_KERNEL_MEMBLOCK_TYPE_USER_RX                 (0x0C20D050)
+#ifndef DT_RELRSZ
+#define DT_RELRSZ 35
+#define DT_RELR 36
 #endif
 
+#define DT_ANDROID_RELR 0x6fffe000
+#define DT_ANDROID_RELRSZ 0x6fffe001
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t so_digest;
+  uint64_t dynlib_digest;
+  uint32_t text_base, text_size;
+  uint32_t data_base, data_size;
+  uint32_t num_slots;
+} so_cache_header;
+
+// A word that relocation or resolution changed, the rest of the image is what so_load streamed
+typedef struct {
+  uint32_t offset;
+  uint32_t value;
+} so_cache_slot;
+
+// Sidecar written by tools/relr_pack.c, followed by the RELR words and the remaining .rel.dyn entries
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t so_digest;
+  uint32_t num_relr;
+  uint32_t num_reldyn;
+} so_relr_header;
+
 static so_module *head = NULL, *tail = NULL;
+static so_module *modules[SO_MAX_MODULES];
+static uint32_t next_load_seq = 0;
+
+typedef struct {
+  uint32_t hash;
+  uint32_t name; // offset into the dynstr of its module
+  uintptr_t addr;
+  uint32_t load_seq;
+  int module;
+  int next;
+} so_global_sym;
+
+// Defined symbols of every module that another module depends on
+static so_global_sym *global_syms = NULL;
+static int num_global_syms = 0, max_global_syms = 0;
+static int *global_buckets = NULL;
+static uint32_t global_mask = 0;
+
+static so_module *so_staged_module(uintptr_t addr) {
+  so_module *mod = head;
+  while (mod) {
+    if (mod->text_pages && addr >= mod->text_base && addr < mod->text_base + mod->text_size)
+      return mod;
+    mod = mod->next;
+  }
+  return NULL;
+}
+
+// Copies a text page out of the RX block the first time it is written to
+static uint8_t *so_stage_page(so_module *mod, uint32_t page) {
+  if (!mod->text_pages[page]) {
+    mod->text_pages[page] = malloc(SO_STAGE_PAGE);
+    if (!mod->text_pages[page])
+      fatal_error("Error could not stage text page %x.", page * SO_STAGE_PAGE);
+
+    uint32_t size = mod->text_size - page * SO_STAGE_PAGE;
+    memcpy(mod->text_pages[page], (void *)(mod->text_base + page * SO_STAGE_PAGE), size < SO_STAGE_PAGE ? size : SO_STAGE_PAGE);
+  }
+  return mod->text_pages[page];
+}
+
+typedef struct {
+  uintptr_t addr;
+  uint32_t size;
+  uint32_t data; // offset into patch_data
+} so_patch;
+
+typedef struct {
+  uintptr_t start, end;
+  uint32_t data; // offset into the merged buffer
+} so_patch_run;
+
+// Patches to committed memory that wait for so_patch_commit, in the order they were made
+static so_patch *patches = NULL;
+static int num_patches = 0, max_patches = 0;
+static uint8_t *patch_data = NULL;
+static uint32_t patch_data_size = 0, max_patch_data = 0;
+static int patch_depth = 0;
+
+static void so_patch_direct(uintptr_t addr, const void *src, size_t size) {
+  kuKernelCpuUnrestrictedMemcpy((void *)addr, src, size);
+  kuKernelFlushCaches((void *)addr, size);
+}
+
+static int so_patch_reserve(size_t size) {
+  if (num_patches == max_patches) {
+    int max = max_patches ? max_patches * 2 : 256;
+    so_patch *p = realloc(patches, max * sizeof(so_patch));
+    if (!p)
+      return -1;
+    patches = p;
+    max_patches = max;
+  }
+
+  if (patch_data_size + size > max_patch_data) {
+    uint32_t max = max_patch_data ? max_patch_data * 2 : 4096;
+    while (max < patch_data_size + size)
+      max *= 2;
+    uint8_t *data = realloc(patch_data, max);
+    if (!data)
+      return -1;
+    patch_data = data;
+    max_patch_data = max;
+  }
+
+  return 0;
+}
+
+static int so_patch_cmp(const void *a, const void *b) {
+  uintptr_t x = patches[*(const int *)a].addr;
+  uintptr_t y = patches[*(const int *)b].addr;
+  return x < y ? -1 : x > y;
+}
+
+// Merges patches whose cache lines touch into runs, so that every dirty line is written and flushed once
+static void so_patch_flush(void) {
+  so_patch_run *runs = NULL;
+  int *order = NULL;
+  uint8_t *buf = NULL;
+  int num_runs = 0;
+  uint32_t buf_size = 0;
+
+  if (num_patches == 0)
+    return;
+
+  order = malloc(num_patches * sizeof(int));
+  runs = malloc(num_patches * sizeof(so_patch_run));
+  if (!order || !runs)
+    goto fallback;
+
+  for (int i = 0; i < num_patches; i++)
+    order[i] = i;
+  qsort(order, num_patches, sizeof(int), so_patch_cmp);
+
+  for (int i = 0; i < num_patches; i++) {
+    so_patch *p = &patches[order[i]];
+    so_patch_run *run = num_runs ? &runs[num_runs - 1] : NULL;
+    if (run && (p->addr & ~(SO_PATCH_LINE - 1)) <= ALIGN_MEM(run->end, SO_PATCH_LINE)) {
+      if (p->addr + p->size > run->end)
+        run->end = p->addr + p->size;
+    } else {
+      run = &runs[num_runs++];
+      run->start = p->addr;
+      run->end = p->addr + p->size;
+    }
+  }
+
+  for (int i = 0; i < num_runs; i++) {
+    runs[i].data = buf_size;
+    buf_size += runs[i].end - runs[i].start;
+  }
+
+  buf = malloc(buf_size);
+  if (!buf)
+    goto fallback;
+
+  // Bytes between two patches of a run are written back unchanged
+  for (int i = 0; i < num_runs; i++)
+    memcpy(buf + runs[i].data, (void *)runs[i].start, runs[i].end - runs[i].start);
+
+  // Replayed in order, so that a later patch of the same bytes wins
+  for (int i = 0; i < num_patches; i++) {
+    so_patch *p = &patches[i];
+    int lo = 0, hi = num_runs - 1;
+    while (lo < hi) {
+      int mid = (lo + hi + 1) / 2;
+      if (runs[mid].start <= p->addr)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+    memcpy(buf + runs[lo].data + (p->addr - runs[lo].start), patch_data + p->data, p->size);
+  }
+
+  for (int i = 0; i < num_runs; i++) {
+    uintptr_t line = runs[i].start & ~(SO_PATCH_LINE - 1);
+    kuKernelCpuUnrestrictedMemcpy((void *)runs[i].start, buf + runs[i].data, runs[i].end - runs[i].start);
+    kuKernelFlushCaches((void *)line, ALIGN_MEM(runs[i].end, SO_PATCH_LINE) - line);
+  }
+
+  goto done;
+
+fallback:
+  for (int i = 0; i < num_patches; i++)
+    so_patch_direct(patches[i].addr, patch_data + patches[i].data, patches[i].size);
+
+done:
+  free(buf);
+  free(runs);
+  free(order);
+  num_patches = 0;
+  patch_data_size = 0;
+}
+
+// Collects patches until the matching so_patch_commit. Transactions nest and are not thread safe.
+void so_patch_begin(void) {
+  patch_depth++;
+}
+
+int so_patch_commit(void) {
+  if (patch_depth == 0 || --patch_depth > 0)
+    return 0;
+
+  int num = num_patches;
+  so_patch_flush();
+  return num;
+}
+
+// Text that has not been committed yet is patched in its staged pages, which so_commit flushes once
+void so_patch_write(uintptr_t addr, const void *src, size_t size) {
+  so_module *mod = so_staged_module(addr);
+  if (mod) {
+    while (size > 0) {
+      uint32_t offset = addr - mod->text_base;
+      uint32_t len = SO_STAGE_PAGE - offset % SO_STAGE_PAGE;
+      if (len > size)
+        len = size;
+      memcpy(so_stage_page(mod, offset / SO_STAGE_PAGE) + offset % SO_STAGE_PAGE, src, len);
+      addr += len;
+      src = (const uint8_t *)src + len;
+      size -= len;
+    }
+    return;
+  }
+
+  if (patch_depth == 0) {
+    so_patch_direct(addr, src, size);
+    return;
+  }
+
+  if (so_patch_reserve(size) < 0) {
+    so_patch_flush();
+    so_patch_direct(addr, src, size);
+    return;
+  }
+
+  patches[num_patches].addr = addr;
+  patches[num_patches].size = size;
+  patches[num_patches].data = patch_data_size;
+  memcpy(patch_data + patch_data_size, src, size);
+  patch_data_size += size;
+  num_patches++;
+}
+
+// Sees the patches of an open transaction, so that hook_wrap relocates what will actually be there
+void so_patch_read(uintptr_t addr, void *dst, size_t size) {
+  so_module *mod = so_staged_module(addr);
+  if (mod) {
+    while (size > 0) {
+      uint32_t offset = addr - mod->text_base;
+      uint32_t len = SO_STAGE_PAGE - offset % SO_STAGE_PAGE;
+      if (len > size)
+        len = size;
+      uint8_t *page = mod->text_pages[offset / SO_STAGE_PAGE];
+      memcpy(dst, page ? page + offset % SO_STAGE_PAGE : (uint8_t *)addr, len);
+      addr += len;
+      dst = (uint8_t *)dst + len;
+      size -= len;
+    }
+    return;
+  }
+
+  memcpy(dst, (void *)addr, size);
+
+  for (int i = 0; i < num_patches; i++) {
+    so_patch *p = &patches[i];
+    uintptr_t start = p->addr > addr ? p->addr : addr;
+    uintptr_t end = p->addr + p->size < addr + size ? p->addr + p->size : addr + size;
+    if (start < end)
+      memcpy((uint8_t *)dst + (start - addr), patch_data + p->data + (start - p->addr), end - start);
+  }
+}
+
+so_module *so_find_module(uintptr_t addr) {
+  so_module *mod = head;
+  while (mod) {
+    if (addr >= mod->text_base && addr < mod->text_base + mod->text_size)
+      return mod;
+    mod = mod->next;
+  }
+  return NULL;
+}
+
+// Remembers what a hook is about to overwrite. Hooks outside of any module can't be undone.
+static void so_hook_record(uintptr_t addr, uint32_t size) {
+  so_module *mod = so_find_module(addr);
+  if (!mod)
+    return;
+
+  if (mod->num_hook_patches == mod->max_hook_patches) {
+    int max = mod->max_hook_patches ? mod->max_hook_patches * 2 : 64;
+    so_hook_patch *p = realloc(mod->hook_patches, max * sizeof(so_hook_patch));
+    if (!p) {
+      debugPrintf("Hook at %08x can't be reverted\n", (uint32_t)addr);
+      return;
+    }
+    mod->hook_patches = p;
+    mod->max_hook_patches = max;
+  }
+
+  so_hook_patch *patch = &mod->hook_patches[mod->num_hook_patches++];
+  patch->addr = addr;
+  patch->size = size;
+  so_patch_read(addr, patch->orig, size);
+}
 
 void hook_thumb(uintptr_t addr, uintptr_t dst) {
   if (addr == 0)
     return;
   addr &= ~1;
+  so_hook_record(addr, (addr & 2) ? 10 : 8);
   if (addr & 2) {
     uint16_t nop = 0xbf00;
-    kuKernelCpuUnrestrictedMemcpy((void *)addr, &nop, sizeof(nop));
+    so_patch_write(addr, &nop, sizeof(nop));
     addr += 2;
   }
   uint32_t hook[2];
   hook[0] = 0xf000f8df; // LDR PC, [PC]
   hook[1] = dst;
-  kuKernelCpuUnrestrictedMemcpy((void *)addr, hook, sizeof(hook));
+  so_patch_write(addr, hook, sizeof(hook));
 }
 
 void hook_arm(uintptr_t addr, uintptr_t dst) {
   if (addr == 0)
     return;
   uint32_t hook[2];
+  so_hook_record(addr, sizeof(hook));
   hook[0] = 0xe51ff004; // LDR PC, [PC, #-0x4]
   hook[1] = dst;
-  kuKernelCpuUnrestrictedMemcpy((void *)addr, hook, sizeof(hook));
+  so_patch_write(addr, hook, sizeof(hook));
 }
 
 void hook_addr(uintptr_t addr, uintptr_t dst) {
   if (addr == 0)
     return;
+  so_patch_begin();
   if (addr & 1)
     hook_thumb(addr, dst);
   else
     hook_arm(addr, dst);
+  so_patch_commit();
+}
+
+int so_hook_table(so_module *mod, so_hook *hooks, int size_hooks, const so_hook_offsets *offsets) {
+  int num_hooks = size_hooks / sizeof(so_hook);
+  int num_missing = 0;
+
+  // Baked offsets are only trusted for the exact image they were generated from
+  int baked = offsets && offsets->digest && offsets->num_offsets == num_hooks &&
+              *offsets->digest == mod->digest;
+
+  so_patch_begin();
+
+  for (int i = 0; i < num_hooks; i++) {
+    uintptr_t addr;
+    if (baked)
+      addr = offsets->offsets[i] ? mod->text_base + offsets->offsets[i] : 0;
+    else
+      addr = so_symbol(mod, hooks[i].symbol);
+    if (!addr) {
+      debugPrintf("Hook target missing: %s\n", hooks[i].symbol);
+      num_missing++;
+      continue;
+    }
+
+    hook_addr(addr, hooks[i].func);
+  }
+
+  so_patch_commit();
+
+  return num_missing;
+}
+
+// Restores hooked code newest first, so that stacked hooks unwind to the original bytes, and
+// gives back the trampolines that jump into the module
+void so_unhook(so_module *mod) {
+  so_patch_begin();
+  for (int i = mod->num_hook_patches - 1; i >= 0; i--)
+    so_patch_write(mod->hook_patches[i].addr, mod->hook_patches[i].orig, mod->hook_patches[i].size);
+  so_patch_commit();
+
+  free(mod->hook_patches);
+  mod->hook_patches = NULL;
+  mod->num_hook_patches = 0;
+  mod->max_hook_patches = 0;
+
+  trampoline_release(mod);
 }
 
 void so_flush_caches(so_module *mod) {
   kuKernelFlushCaches((void *)mod->text_base, mod->text_size);
 }
 
-int so_load(so_module *mod, const char *filename, uintptr_t load_addr) {
-  int res = 0;
-  uintptr_t data_addr = 0;
-  SceUID so_blockid;
-  void *so_data;
-  size_t so_size;
+// Until so_commit, text that was written to only exists in its staged page
+static void *so_view(so_module *mod, uintptr_t vaddr) {
+  if (mod->text_pages && vaddr < mod->text_size && mod->text_pages[vaddr / SO_STAGE_PAGE])
+    return mod->text_pages[vaddr / SO_STAGE_PAGE] + vaddr % SO_STAGE_PAGE;
+  return (void *)(mod->text_base + vaddr);
+}
 
-  memset(mod, 0, sizeof(so_module));
+// Relocation targets, which stage the text page they are in. ELF32 slots are 32-bit and aligned.
+static uint32_t *so_slot(so_module *mod, uintptr_t vaddr) {
+  if (mod->text_pages && vaddr < mod->text_size)
+    return (uint32_t *)(so_stage_page(mod, vaddr / SO_STAGE_PAGE) + vaddr % SO_STAGE_PAGE);
+  return (uint32_t *)(mod->text_base + vaddr);
+}
 
-  SceUID fd = sceIoOpen(filename, SCE_O_RDONLY, 0);
-  if (fd < 0)
-    return fd;
+static void so_stage_free(so_module *mod) {
+  if (!mod->text_pages)
+    return;
+  for (int i = 0; i < ALIGN_MEM(mod->text_size, SO_STAGE_PAGE) / SO_STAGE_PAGE; i++)
+    free(mod->text_pages[i]);
+  free(mod->text_pages);
+  mod->text_pages = NULL;
+}
 
-  so_size = sceIoLseek(fd, 0, SCE_SEEK_END);
-  sceIoLseek(fd, 0, SCE_SEEK_SET);
+// The RX block already holds the file image, only the staged pages are copied over it
+int so_commit(so_module *mod) {
+  if (!mod->text_pages)
+    return 0;
 
-  so_blockid = sceKernelAllocMemBlock("file", SCE_KERNEL_MEMBLOCK_TYPE_USER_RW, (so_size + 0xfff) & ~0xfff, NULL);
-  if (so_blockid < 0)
-    return so_blockid;
+  for (int i = 0; i < ALIGN_MEM(mod->text_size, SO_STAGE_PAGE) / SO_STAGE_PAGE; i++) {
+    if (!mod->text_pages[i])
+      continue;
+    uint32_t size = mod->text_size - i * SO_STAGE_PAGE;
+    kuKernelCpuUnrestrictedMemcpy((void *)(mod->text_base + i * SO_STAGE_PAGE), mod->text_pages[i], size < SO_STAGE_PAGE ? size : SO_STAGE_PAGE);
+  }
+  kuKernelFlushCaches((void *)mod->text_base, mod->text_size);
 
-  sceKernelGetMemBlockBase(so_blockid, &so_data);
+  so_stage_free(mod);
 
-  sceIoRead(fd, so_data, so_size);
-  sceIoClose(fd);
+  return 0;
+}
 
-  if (memcmp(so_data, ELFMAG, SELFMAG) != 0) {
-    res = -1;
-    goto err_free_so;
+static int so_read(SceUID fd, void *buf, size_t size, uint32_t offset) {
+  if (sceIoLseek(fd, offset, SCE_SEEK_SET) != offset)
+    return -1;
+  if (sceIoRead(fd, buf, size) != size)
+    return -1;
+  return 0;
+}
+
+typedef struct {
+  SceUID fd;
+  uint32_t offset; // file offset of the first byte
+  uint32_t size; // uncompressed size
+  uint32_t comp_size;
+  uint32_t comp_pos;
+  uint32_t pos;
+  int deflated;
+  z_stream strm;
+  uint8_t *chunk;
+  uint8_t *scratch;
+} so_reader;
+
+static uint16_t zip_u16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t zip_u32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+static int so_reader_open_file(so_reader *r, const char *filename) {
+  memset(r, 0, sizeof(so_reader));
+
+  r->fd = sceIoOpen(filename, SCE_O_RDONLY, 0);
+  if (r->fd < 0)
+    return r->fd;
+
+  r->size = sceIoLseek(r->fd, 0, SCE_SEEK_END);
+  return 0;
+}
+
+static int so_reader_open_apk(so_reader *r, const char *apk_path, const char *entry) {
+  uint8_t *buf = NULL;
+  int res = -1;
+
+  memset(r, 0, sizeof(so_reader));
+
+  r->fd = sceIoOpen(apk_path, SCE_O_RDONLY, 0);
+  if (r->fd < 0)
+    return r->fd;
+
+  uint32_t apk_size = sceIoLseek(r->fd, 0, SCE_SEEK_END);
+  if (apk_size < ZIP_EOCD_SIZE)
+    goto err_close;
+
+  // The end of central directory record sits behind an optional comment
+  uint32_t tail_size = apk_size < ZIP_EOCD_SIZE + ZIP_MAX_COMMENT ? apk_size : ZIP_EOCD_SIZE + ZIP_MAX_COMMENT;
+  buf = malloc(tail_size);
+  if (!buf || so_read(r->fd, buf, tail_size, apk_size - tail_size) < 0)
+    goto err_close;
+
+  uint8_t *eocd = NULL;
+  for (int i = tail_size - ZIP_EOCD_SIZE; i >= 0; i--) {
+    if (zip_u32(&buf[i]) == ZIP_EOCD_MAGIC) {
+      eocd = &buf[i];
+      break;
+    }
+  }
+  if (!eocd)
+    goto err_close;
+
+  uint32_t cdir_size = zip_u32(&eocd[12]);
+  uint32_t cdir_offset = zip_u32(&eocd[16]);
+  uint16_t num_entries = zip_u16(&eocd[10]);
+
+  free(buf);
+  buf = malloc(cdir_size);
+  if (!buf || so_read(r->fd, buf, cdir_size, cdir_offset) < 0)
+    goto err_close;
+
+  size_t entry_len = strlen(entry);
+  uint8_t *cdir = buf;
+  uint8_t *local = NULL;
+  for (int i = 0; i < num_entries && cdir + ZIP_CDIR_SIZE <= buf + cdir_size; i++) {
+    if (zip_u32(cdir) != ZIP_CDIR_MAGIC)
+      goto err_close;
+
+    uint16_t name_len = zip_u16(&cdir[28]);
+    if (name_len == entry_len && memcmp(&cdir[ZIP_CDIR_SIZE], entry, entry_len) == 0) {
+      local = cdir;
+      break;
+    }
+
+    cdir += ZIP_CDIR_SIZE + name_len + zip_u16(&cdir[30]) + zip_u16(&cdir[32]);
+  }
+  if (!local)
+    goto err_close;
+
+  uint16_t method = zip_u16(&local[10]);
+  r->comp_size = zip_u32(&local[20]);
+  r->size = zip_u32(&local[24]);
+  uint32_t local_offset = zip_u32(&local[42]);
+
+  uint8_t local_hdr[ZIP_LOCAL_SIZE];
+  if (so_read(r->fd, local_hdr, ZIP_LOCAL_SIZE, local_offset) < 0 || zip_u32(local_hdr) != ZIP_LOCAL_MAGIC)
+    goto err_close;
+
+  r->offset = local_offset + ZIP_LOCAL_SIZE + zip_u16(&local_hdr[26]) + zip_u16(&local_hdr[28]);
+
+  if (method == Z_DEFLATED) {
+    r->chunk = malloc(SO_READER_CHUNK);
+    r->scratch = malloc(SO_READER_CHUNK);
+    if (!r->chunk || !r->scratch || inflateInit2(&r->strm, -MAX_WBITS) != Z_OK)
+      goto err_close;
+    r->deflated = 1;
+  } else if (method != 0) {
+    goto err_close;
+  }
+
+  free(buf);
+  return 0;
+
+err_close:
+  free(r->scratch);
+  free(r->chunk);
+  free(buf);
+  sceIoClose(r->fd);
+  return res;
+}
+
+static void so_reader_close(so_reader *r) {
+  if (r->deflated)
+    inflateEnd(&r->strm);
+  free(r->scratch);
+  free(r->chunk);
+  sceIoClose(r->fd);
+}
+
+static int so_reader_inflate(so_reader *r, void *buf, size_t size) {
+  r->strm.next_out = buf;
+  r->strm.avail_out = size;
+
+  while (r->strm.avail_out) {
+    if (r->strm.avail_in == 0) {
+      uint32_t len = r->comp_size - r->comp_pos;
+      if (len > SO_READER_CHUNK)
+        len = SO_READER_CHUNK;
+      if (len == 0 || so_read(r->fd, r->chunk, len, r->offset + r->comp_pos) < 0)
+        return -1;
+      r->comp_pos += len;
+      r->strm.next_in = r->chunk;
+      r->strm.avail_in = len;
+    }
+
+    int res = inflate(&r->strm, Z_NO_FLUSH);
+    if (res == Z_STREAM_END)
+      break;
+    if (res != Z_OK)
+      return -1;
+  }
+
+  if (r->strm.avail_out)
+    return -1;
+
+  r->pos += size;
+  return 0;
+}
+
+static int so_reader_read(so_reader *r, void *buf, size_t size, uint32_t offset) {
+  if (offset + size > r->size)
+    return -1;
+
+  if (!r->deflated)
+    return so_read(r->fd, buf, size, r->offset + offset);
+
+  // Deflated entries can only be read forward, going back means inflating again from the start
+  if (offset < r->pos) {
+    if (inflateReset(&r->strm) != Z_OK)
+      return -1;
+    r->strm.avail_in = 0;
+    r->comp_pos = 0;
+    r->pos = 0;
+  }
+
+  while (r->pos < offset) {
+    uint32_t len = offset - r->pos;
+    if (len > SO_READER_CHUNK)
+      len = SO_READER_CHUNK;
+    if (so_reader_inflate(r, r->scratch, len) < 0)
+      return -1;
+  }
+
+  return so_reader_inflate(r, buf, size);
+}
+
+static int so_addr_sym_compare(const void *a, const void *b) {
+  const so_addr_sym *sa = (const so_addr_sym *)a;
+  const so_addr_sym *sb = (const so_addr_sym *)b;
+  if (sa->addr != sb->addr)
+    return sa->addr < sb->addr ? -1 : 1;
+  // Prefer the alias with the largest extent
+  return (sa->size < sb->size) - (sa->size > sb->size);
+}
+
+static void so_addr_sym_add(so_module *mod, Elf32_Sym *sym, int symtab) {
+  int type = ELF32_ST_TYPE(sym->st_info);
+  if (sym->st_shndx == SHN_UNDEF || sym->st_value == 0 || (type != STT_FUNC && type != STT_OBJECT))
+    return;
+
+  so_addr_sym *entry = &mod->addr_syms[mod->num_addr_syms++];
+  entry->addr = sym->st_value & ~1;
+  entry->size = sym->st_size;
+  entry->name = sym->st_name;
+  entry->symtab = symtab;
+}
+
+// Sorted by address so so_addr2sym can binary search. The index is optional, failures only leave it empty.
+static void so_addr_index_build(so_module *mod, so_reader *r, Elf32_Ehdr *ehdr) {
+  Elf32_Shdr *shdr = NULL;
+  Elf32_Sym *symtab = NULL;
+  int num_symtab = 0;
+
+  // .symtab is not part of any segment and only there if the library was not stripped. It sits in
+  // front of the section headers, which a deflated entry can only get back to by inflating the whole
+  // library again, so those are indexed from .dynsym alone.
+  if (!r->deflated && ehdr->e_shoff && ehdr->e_shnum && ehdr->e_shentsize == sizeof(Elf32_Shdr)) {
+    shdr = malloc(ehdr->e_shnum * sizeof(Elf32_Shdr));
+    if (shdr && so_reader_read(r, shdr, ehdr->e_shnum * sizeof(Elf32_Shdr), ehdr->e_shoff) == 0) {
+      for (int i = 0; i < ehdr->e_shnum; i++) {
+        if (shdr[i].sh_type != SHT_SYMTAB || shdr[i].sh_link >= ehdr->e_shnum)
+          continue;
+
+        Elf32_Shdr *strtab = &shdr[shdr[i].sh_link];
+        symtab = malloc(shdr[i].sh_size);
+        mod->symstr = malloc(strtab->sh_size);
+        if (symtab && mod->symstr &&
+            so_reader_read(r, symtab, shdr[i].sh_size, shdr[i].sh_offset) == 0 &&
+            so_reader_read(r, mod->symstr, strtab->sh_size, strtab->sh_offset) == 0) {
+          num_symtab = shdr[i].sh_size / sizeof(Elf32_Sym);
+        } else {
+          free(symtab);
+          symtab = NULL;
+          free(mod->symstr);
+          mod->symstr = NULL;
+        }
+        break;
+      }
+    }
+    free(shdr);
   }
 
-  mod->ehdr = (Elf32_Ehdr *)so_data;
-  mod->phdr = (Elf32_Phdr *)((uintptr_t)so_data + mod->ehdr->e_phoff);
-  mod->shdr = (Elf32_Shdr *)((uintptr_t)so_data + mod->ehdr->e_shoff);
+  mod->addr_syms = malloc((mod->num_dynsym + num_symtab) * sizeof(so_addr_sym));
+  if (!mod->addr_syms) {
+    free(symtab);
+    free(mod->symstr);
+    mod->symstr = NULL;
+    return;
+  }
+
+  for (int i = 0; i < mod->num_dynsym; i++)
+    so_addr_sym_add(mod, &mod->dynsym[i], 0);
+  for (int i = 0; i < num_symtab; i++)
+    so_addr_sym_add(mod, &symtab[i], 1);
+
+  free(symtab);
+
+  qsort(mod->addr_syms, mod->num_addr_syms, sizeof(so_addr_sym), so_addr_sym_compare);
+
+  // Exported symbols show up in both tables, keep one entry per address
+  int num = 0;
+  for (int i = 0; i < mod->num_addr_syms; i++) {
+    if (num == 0 || mod->addr_syms[i].addr != mod->addr_syms[num - 1].addr)
+      mod->addr_syms[num++] = mod->addr_syms[i];
+  }
+  mod->num_addr_syms = num;
+}
+
+// The RX block is only writable through the kernel, so the text goes through a bounce buffer
+static int so_load_text(so_module *mod, so_reader *r, Elf32_Phdr *phdr, XXH64_CTX *ctx) {
+  uint8_t *bounce = malloc(SO_READER_CHUNK);
+  if (!bounce)
+    return -3;
+
+  for (uint32_t offset = 0; offset < phdr->p_memsz; offset += SO_READER_CHUNK) {
+    uint32_t len = phdr->p_memsz - offset;
+    if (len > SO_READER_CHUNK)
+      len = SO_READER_CHUNK;
+    uint32_t file_len = offset < phdr->p_filesz ? phdr->p_filesz - offset : 0;
+    if (file_len > len)
+      file_len = len;
+
+    if (so_reader_read(r, bounce, file_len, phdr->p_offset + offset) < 0) {
+      free(bounce);
+      return -1;
+    }
+    memset(bounce + file_len, 0, len - file_len);
+
+    xxh64_update(ctx, bounce, file_len);
+    kuKernelCpuUnrestrictedMemcpy((void *)(mod->text_base + offset), bounce, len);
+  }
+
+  free(bounce);
+  return 0;
+}
+
+static int so_load_reader(so_module *mod, so_reader *r, uintptr_t load_addr) {
+  int res = 0;
+  uintptr_t data_addr = 0;
+  Elf32_Ehdr ehdr;
+  Elf32_Phdr *phdr = NULL;
+  XXH64_CTX ctx;
+
+  memset(mod, 0, sizeof(so_module));
+
+  // Only the headers are read up front, segments are streamed to their destination
+  if (so_reader_read(r, &ehdr, sizeof(Elf32_Ehdr), 0) < 0 || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0)
+    return -1;
+
+  phdr = malloc(ehdr.e_phnum * sizeof(Elf32_Phdr));
+  if (!phdr)
+    return -3;
 
-  mod->shstr = (char *)((uintptr_t)so_data + mod->shdr[mod->ehdr->e_shstrndx].sh_offset);
+  if (so_reader_read(r, phdr, ehdr.e_phnum * sizeof(Elf32_Phdr), ehdr.e_phoff) < 0) {
+    res = -1;
+    goto err_free_headers;
+  }
 
-  for (int i = 0; i < mod->ehdr->e_phnum; i++) {
-    if (mod->phdr[i].p_type == PT_LOAD) {
+  // The digest covers everything that ends up in memory, so it keys the prelink cache. XXH64 keeps
+  // up with inflating and costs next to nothing on top of copying the segments.
+  xxh64_init(&ctx, 0);
+  xxh64_update(&ctx, &ehdr, sizeof(Elf32_Ehdr));
+  xxh64_update(&ctx, phdr, ehdr.e_phnum * sizeof(Elf32_Phdr));
+
+  for (int i = 0; i < ehdr.e_phnum; i++) {
+    if (phdr[i].p_type == PT_LOAD) {
       void *prog_data;
       size_t prog_size;
 
-      if ((mod->phdr[i].p_flags & PF_X) == PF_X) {
-        prog_size = ALIGN_MEM(mod->phdr[i].p_memsz, mod->phdr[i].p_align);
+      if ((phdr[i].p_flags & PF_X) == PF_X) {
+        prog_size = ALIGN_MEM(phdr[i].p_memsz, phdr[i].p_align);
 
         SceKernelAllocMemBlockKernelOpt opt;
         memset(&opt, 0, sizeof(SceKernelAllocMemBlockKernelOpt));
@@ -111,21 +839,31 @@ int so_load(so_module *mod, const char *filename, uintptr_t load_addr) {
         opt.field_C = (SceUInt32)load_addr;
         res = mod->text_blockid = kuKernelAllocMemBlock("rx_block", SCE_KERNEL_MEMBLOCK_TYPE_USER_RX, prog_size, &opt);
         if (res < 0)
-          goto err_free_so;
+          goto err_free_headers;
 
         sceKernelGetMemBlockBase(mod->text_blockid, &prog_data);
 
-        mod->phdr[i].p_vaddr += (Elf32_Addr)prog_data;
+        mod->text_base = (uintptr_t)prog_data + phdr[i].p_vaddr;
+        mod->text_size = phdr[i].p_memsz;
+
+        mod->text_pages = calloc(ALIGN_MEM(mod->text_size, SO_STAGE_PAGE) / SO_STAGE_PAGE, sizeof(uint8_t *));
+        if (!mod->text_pages) {
+          res = -3;
+          goto err_free_text;
+        }
 
-        mod->text_base = mod->phdr[i].p_vaddr;
-        mod->text_size = mod->phdr[i].p_memsz;
+        res = so_load_text(mod, r, &phdr[i], &ctx);
+        if (res < 0)
+          goto err_free_text;
 
         data_addr = (uintptr_t)prog_data + prog_size;
       } else {
-        if (data_addr == 0)
-          goto err_free_so;
+        if (data_addr == 0) {
+          res = -1;
+          goto err_free_headers;
+        }
 
-        prog_size = ALIGN_MEM(mod->phdr[i].p_memsz + mod->phdr[i].p_vaddr - (data_addr - mod->text_base), mod->phdr[i].p_align);
+        prog_size = ALIGN_MEM(phdr[i].p_memsz + phdr[i].p_vaddr - (data_addr - mod->text_base), phdr[i].p_align);
 
         SceKernelAllocMemBlockKernelOpt opt;
         memset(&opt, 0, sizeof(SceKernelAllocMemBlockKernelOpt));
@@ -136,117 +874,221 @@ int so_load(so_module *mod, const char *filename, uintptr_t load_addr) {
         if (res < 0)
           goto err_free_text;
 
-        sceKernelGetMemBlockBase(mod->data_blockid, &prog_data);
-
-        mod->phdr[i].p_vaddr += (Elf32_Addr)mod->text_base;
+        mod->data_base = mod->text_base + phdr[i].p_vaddr;
+        mod->data_size = phdr[i].p_memsz;
 
-        mod->data_base = mod->phdr[i].p_vaddr;
-        mod->data_size = mod->phdr[i].p_memsz;
-      }
+        void *dest = (void *)mod->data_base;
+        if (so_reader_read(r, dest, phdr[i].p_filesz, phdr[i].p_offset) < 0) {
+          res = -1;
+          goto err_free_data;
+        }
 
-      char *zero = malloc(prog_size);
-      memset(zero, 0, prog_size);
-      kuKernelCpuUnrestrictedMemcpy(prog_data, zero, prog_size);
-      free(zero);
+        memset(dest + phdr[i].p_filesz, 0, phdr[i].p_memsz - phdr[i].p_filesz);
 
-      kuKernelCpuUnrestrictedMemcpy((void *)mod->phdr[i].p_vaddr, (void *)((uintptr_t)so_data + mod->phdr[i].p_offset), mod->phdr[i].p_filesz);
+        xxh64_update(&ctx, dest, phdr[i].p_filesz);
+      }
     }
   }
 
-  for (int i = 0; i < mod->ehdr->e_shnum; i++) {
-    char *sh_name = mod->shstr + mod->shdr[i].sh_name;
-    uintptr_t sh_addr = mod->text_base + mod->shdr[i].sh_addr;
-    size_t sh_size = mod->shdr[i].sh_size;
-    if (strcmp(sh_name, ".dynamic") == 0) {
-      mod->dynamic = (Elf32_Dyn *)sh_addr;
-      mod->num_dynamic = sh_size / sizeof(Elf32_Dyn);
-    } else if (strcmp(sh_name, ".dynstr") == 0) {
-      mod->dynstr = (char *)sh_addr;
-    } else if (strcmp(sh_name, ".dynsym") == 0) {
-      mod->dynsym = (Elf32_Sym *)sh_addr;
-      mod->num_dynsym = sh_size / sizeof(Elf32_Sym);
-    } else if (strcmp(sh_name, ".rel.dyn") == 0) {
-      mod->reldyn = (Elf32_Rel *)sh_addr;
-      mod->num_reldyn = sh_size / sizeof(Elf32_Rel);
-    } else if (strcmp(sh_name, ".rel.plt") == 0) {
-      mod->relplt = (Elf32_Rel *)sh_addr;
-      mod->num_relplt = sh_size / sizeof(Elf32_Rel);
-    } else if (strcmp(sh_name, ".init_array") == 0) {
-      mod->init_array = (void *)sh_addr;
-      mod->num_init_array = sh_size / sizeof(void *);
-    } else if (strcmp(sh_name, ".hash") == 0) {
-      mod->hash = (void *)sh_addr;
+  mod->digest = xxh64_final(&ctx);
+
+  // Everything the dynamic linker needs is reachable from PT_DYNAMIC, section headers may be stripped
+  for (int i = 0; i < ehdr.e_phnum; i++) {
+    if (phdr[i].p_type == PT_DYNAMIC) {
+      mod->dynamic = so_view(mod, phdr[i].p_vaddr);
+      mod->num_dynamic = phdr[i].p_memsz / sizeof(Elf32_Dyn);
+      break;
     }
   }
 
-  if (mod->dynamic == NULL ||
-      mod->dynstr == NULL ||
-      mod->dynsym == NULL ||
-      mod->reldyn == NULL ||
-      mod->relplt == NULL) {
+  if (mod->dynamic == NULL) {
     res = -2;
     goto err_free_data;
   }
 
+  size_t relsz = 0, pltrelsz = 0, relrsz = 0, init_arraysz = 0;
+  uintptr_t soname = 0;
+
   for (int i = 0; i < mod->num_dynamic; i++) {
+    uintptr_t d_ptr = mod->dynamic[i].d_un.d_ptr;
     switch (mod->dynamic[i].d_tag) {
+      case DT_NULL:
+        mod->num_dynamic = i;
+        break;
       case DT_SONAME:
-        mod->soname = mod->dynstr + mod->dynamic[i].d_un.d_ptr;
+        soname = d_ptr;
+        break;
+      case DT_STRTAB:
+        mod->dynstr = so_view(mod, d_ptr);
+        break;
+      case DT_SYMTAB:
+        mod->dynsym = so_view(mod, d_ptr);
+        break;
+      case DT_REL:
+        mod->reldyn = so_view(mod, d_ptr);
+        break;
+      case DT_RELSZ:
+        relsz = d_ptr;
+        break;
+      case DT_JMPREL:
+        mod->relplt = so_view(mod, d_ptr);
+        break;
+      case DT_PLTRELSZ:
+        pltrelsz = d_ptr;
+        break;
+      case DT_INIT_ARRAY:
+        mod->init_array = so_view(mod, d_ptr);
+        break;
+      case DT_INIT_ARRAYSZ:
+        init_arraysz = d_ptr;
+        break;
+      case DT_HASH:
+        mod->hash = so_view(mod, d_ptr);
+        break;
+      case DT_GNU_HASH:
+        mod->gnu_hash = so_view(mod, d_ptr);
+        break;
+      case DT_RELR:
+      case DT_ANDROID_RELR:
+        mod->relr = so_view(mod, d_ptr);
+        break;
+      case DT_RELRSZ:
+      case DT_ANDROID_RELRSZ:
+        relrsz = d_ptr;
         break;
       default:
         break;
     }
   }
 
-  sceKernelFreeMemBlock(so_blockid);
-
-  if (!head && !tail) {
-    head = mod;
-    tail = mod;
-  } else {
-    tail->next = mod;
-    tail = mod;
+  if (mod->dynstr == NULL || mod->dynsym == NULL) {
+    res = -2;
+    goto err_free_data;
   }
 
-  return 0;
+  mod->num_reldyn = relsz / sizeof(Elf32_Rel);
+  mod->num_relplt = pltrelsz / sizeof(Elf32_Rel);
+  mod->num_relr = relrsz / sizeof(uint32_t);
+  mod->num_init_array = init_arraysz / sizeof(void *);
 
-err_free_data:
-  sceKernelFreeMemBlock(mod->data_blockid);
-err_free_text:
+  if (soname)
+    mod->soname = mod->dynstr + soname;
+
+  // There is no DT_ tag for the symbol count, it has to be derived from the hash tables
+  if (mod->hash) {
+    mod->num_dynsym = mod->hash[1];
+  } else if (mod->gnu_hash) {
+    uint32_t nbucket = mod->gnu_hash[0];
+    uint32_t symoffset = mod->gnu_hash[1];
+    uint32_t *bucket = &mod->gnu_hash[4 + mod->gnu_hash[2]];
+    uint32_t *chain = &bucket[nbucket];
+    uint32_t last = 0;
+    for (int i = 0; i < nbucket; i++) {
+      if (bucket[i] > last)
+        last = bucket[i];
+    }
+    if (last >= symoffset) {
+      while ((chain[last - symoffset] & 1) == 0)
+        last++;
+      mod->num_dynsym = last + 1;
+    } else {
+      mod->num_dynsym = symoffset;
+    }
+  } else if ((uintptr_t)mod->dynstr > (uintptr_t)mod->dynsym) {
+    // Without any hash table, rely on .dynstr directly following .dynsym
+    mod->num_dynsym = ((uintptr_t)mod->dynstr - (uintptr_t)mod->dynsym) / sizeof(Elf32_Sym);
+  }
+
+  so_addr_index_build(mod, r, &ehdr);
+
+  free(phdr);
+
+  // Ids are reused after an unload, the sequence number keeps the load order
+  mod->id = -1;
+  mod->load_seq = next_load_seq++;
+  for (int i = 0; i < SO_MAX_MODULES; i++) {
+    if (!modules[i]) {
+      modules[i] = mod;
+      mod->id = i;
+      break;
+    }
+  }
+
+  if (!head && !tail) {
+    head = mod;
+    tail = mod;
+  } else {
+    tail->next = mod;
+    tail = mod;
+  }
+
+  return 0;
+
+err_free_data:
+  if (mod->data_blockid > 0)
+    sceKernelFreeMemBlock(mod->data_blockid);
+err_free_text:
+  so_stage_free(mod);
   sceKernelFreeMemBlock(mod->text_blockid);
-err_free_so:
-  sceKernelFreeMemBlock(so_blockid);
+err_free_headers:
+  free(phdr);
 
   return res;
 }
 
-int so_relocate(so_module *mod) {
-  uintptr_t val;
-  for (int i = 0; i < mod->num_reldyn + mod->num_relplt; i++) {
-    Elf32_Rel *rel = i < mod->num_reldyn ? &mod->reldyn[i] : &mod->relplt[i - mod->num_reldyn];
+int so_load(so_module *mod, const char *filename, uintptr_t load_addr) {
+  so_reader r;
+  int res;
+
+  res = so_reader_open_file(&r, filename);
+  if (res < 0)
+    return res;
+
+  res = so_load_reader(mod, &r, load_addr);
+  so_reader_close(&r);
+  return res;
+}
+
+int so_load_apk(so_module *mod, const char *apk_path, const char *entry, uintptr_t load_addr) {
+  so_reader r;
+  int res;
+
+  res = so_reader_open_apk(&r, apk_path, entry);
+  if (res < 0)
+    return res;
+
+  res = so_load_reader(mod, &r, load_addr);
+  so_reader_close(&r);
+  return res;
+}
+
+static Elf32_Rel *so_rel_at(so_module *mod, int i) {
+  return i < mod->num_reldyn ? &mod->reldyn[i] : &mod->relplt[i - mod->num_reldyn];
+}
+
+static void so_relocate_range(so_module *mod, int start, int end) {
+  for (int i = start; i < end; i++) {
+    Elf32_Rel *rel = so_rel_at(mod, i);
     Elf32_Sym *sym = &mod->dynsym[ELF32_R_SYM(rel->r_info)];
-    uintptr_t *ptr = (uintptr_t *)(mod->text_base + rel->r_offset);
+    uint32_t *ptr = so_slot(mod, rel->r_offset);
 
     int type = ELF32_R_TYPE(rel->r_info);
     switch (type) {
       case R_ARM_ABS32:
         if (sym->st_shndx != SHN_UNDEF) {
-          val = *ptr + mod->text_base + sym->st_value;
-          kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
+          *ptr += mod->text_base + sym->st_value;
         }
         break;
 
       case R_ARM_RELATIVE:
-        val = *ptr + mod->text_base;
-        kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
+        *ptr += mod->text_base;
         break;
 
       case R_ARM_GLOB_DAT:
       case R_ARM_JUMP_SLOT:
       {
         if (sym->st_shndx != SHN_UNDEF) {
-          val = mod->text_base + sym->st_value;
-          kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
+          *ptr = mod->text_base + sym->st_value;
         }
         break;
       }
@@ -256,41 +1098,368 @@ int so_relocate(so_module *mod) {
         break;
     }
   }
+}
+
+// An even word is the address of the next relative relocation. An odd word is a bitmap
+// of which of the following 31 words are relocated as well.
+static void so_relocate_relr(so_module *mod) {
+  uint32_t base = 0;
+
+  for (int i = 0; i < mod->num_relr; i++) {
+    uint32_t entry = mod->relr[i];
+    if ((entry & 1) == 0) {
+      *so_slot(mod, entry) += mod->text_base;
+      base = entry + sizeof(uint32_t);
+    } else {
+      uint32_t where = base;
+      for (entry >>= 1; entry; entry >>= 1, where += sizeof(uint32_t)) {
+        if (entry & 1)
+          *so_slot(mod, where) += mod->text_base;
+      }
+      base += 31 * sizeof(uint32_t);
+    }
+  }
+}
 
+int so_relocate(so_module *mod) {
+  so_relocate_relr(mod);
+  so_relocate_range(mod, 0, mod->num_reldyn + mod->num_relplt);
   return 0;
 }
 
-uintptr_t so_resolve_link(so_module *mod, const char *symbol) {
+// Swaps in packed relative relocations from a sidecar that was generated for exactly this image
+int so_relr_load(so_module *mod, const char *path) {
+  so_relr_header hdr;
+  int res = 0;
+
+  if (mod->relr)
+    return -1;
+
+  SceUID fd = sceIoOpen(path, SCE_O_RDONLY, 0);
+  if (fd < 0)
+    return fd;
+
+  if (sceIoRead(fd, &hdr, sizeof(so_relr_header)) != sizeof(so_relr_header) ||
+      hdr.magic != SO_RELR_MAGIC || hdr.version != SO_RELR_VERSION ||
+      hdr.so_digest != mod->digest ||
+      hdr.num_reldyn > mod->num_reldyn) {
+    res = -1;
+    goto err_close;
+  }
+
+  size_t size = hdr.num_relr * sizeof(uint32_t) + hdr.num_reldyn * sizeof(Elf32_Rel);
+  mod->relr_sidecar = malloc(size);
+  if (!mod->relr_sidecar) {
+    res = -3;
+    goto err_close;
+  }
+
+  if (sceIoRead(fd, mod->relr_sidecar, size) != size) {
+    free(mod->relr_sidecar);
+    mod->relr_sidecar = NULL;
+    res = -1;
+    goto err_close;
+  }
+
+  mod->relr = mod->relr_sidecar;
+  mod->num_relr = hdr.num_relr;
+  mod->reldyn = (Elf32_Rel *)(mod->relr + hdr.num_relr);
+  mod->num_reldyn = hdr.num_reldyn;
+
+err_close:
+  sceIoClose(fd);
+  return res;
+}
+
+static void so_global_rehash(void) {
+  memset(global_buckets, 0xff, (global_mask + 1) * sizeof(int));
+  for (int i = 0; i < num_global_syms; i++) {
+    int *bucket = &global_buckets[global_syms[i].hash & global_mask];
+    global_syms[i].next = *bucket;
+    *bucket = i;
+  }
+}
+
+static int so_global_grow(void) {
+  int max = max_global_syms ? max_global_syms * 2 : 1024;
+
+  // Both tables are allocated before anything is released, a failure leaves the index usable
+  int *buckets = malloc(max * 2 * sizeof(int));
+  if (!buckets)
+    return -1;
+
+  so_global_sym *syms = realloc(global_syms, max * sizeof(so_global_sym));
+  if (!syms) {
+    free(buckets);
+    return -1;
+  }
+
+  // Keep the table at most half full, buckets are rebuilt from the entries
+  free(global_buckets);
+  global_syms = syms;
+  global_buckets = buckets;
+  max_global_syms = max;
+  global_mask = max * 2 - 1;
+
+  so_global_rehash();
+  return 0;
+}
+
+static void so_global_remove(so_module *mod) {
+  int num = 0;
+
+  for (int i = 0; i < num_global_syms; i++) {
+    if (global_syms[i].module != mod->id)
+      global_syms[num++] = global_syms[i];
+  }
+
+  if (num != num_global_syms) {
+    num_global_syms = num;
+    so_global_rehash();
+  }
+
+  mod->indexed = 0;
+}
+
+static int so_global_index(so_module *mod) {
+  if (mod->indexed)
+    return 0;
+
+  for (int i = 1; i < mod->num_dynsym; i++) {
+    Elf32_Sym *sym = &mod->dynsym[i];
+    if (sym->st_shndx == SHN_UNDEF || sym->st_info == SHN_UNDEF)
+      continue;
+
+    if (num_global_syms == max_global_syms && so_global_grow() < 0) {
+      // Don't leave half a module behind, a later attempt would index it twice
+      so_global_remove(mod);
+      return -1;
+    }
+
+    so_global_sym *global = &global_syms[num_global_syms];
+    global->hash = so_gnu_hash((const uint8_t *)mod->dynstr + sym->st_name);
+    global->name = sym->st_name;
+    global->addr = mod->text_base + sym->st_value;
+    global->load_seq = mod->load_seq;
+    global->module = mod->id;
+
+    int *bucket = &global_buckets[global->hash & global_mask];
+    global->next = *bucket;
+    *bucket = num_global_syms++;
+  }
+
+  mod->indexed = 1;
+  return 0;
+}
+
+// Matches DT_NEEDED entries to loaded modules once, instead of once per import
+static void so_link_needed(so_module *mod) {
+  mod->needed_mask = 0;
+
   for (int i = 0; i < mod->num_dynamic; i++) {
-    switch (mod->dynamic[i].d_tag) {
-      case DT_NEEDED:
-      {
-        so_module *curr = head;
-        while (curr) {
-          if (curr != mod && strcmp(curr->soname, mod->dynstr + mod->dynamic[i].d_un.d_ptr) == 0) {
-            uintptr_t link = so_symbol(curr, symbol);
-            if (link)
-              return link;
-          }
-          curr = curr->next;
-        }
+    if (mod->dynamic[i].d_tag != DT_NEEDED)
+      continue;
 
+    so_module *curr = head;
+    while (curr) {
+      if (curr != mod && curr->id >= 0 && curr->soname &&
+          strcmp(curr->soname, mod->dynstr + mod->dynamic[i].d_un.d_ptr) == 0) {
+        if (so_global_index(curr) == 0)
+          mod->needed_mask |= 1u << curr->id;
         break;
       }
-      default:
-        break;
+      curr = curr->next;
     }
   }
+}
+
+uintptr_t so_resolve_link(so_module *mod, const char *symbol) {
+  if (!mod->needed_mask || !global_buckets)
+    return 0;
+
+  uint32_t hash = so_gnu_hash((const uint8_t *)symbol);
+  so_global_sym *found = NULL;
+
+  // Modules interpose each other in load order
+  for (int i = global_buckets[hash & global_mask]; i >= 0; i = global_syms[i].next) {
+    so_global_sym *global = &global_syms[i];
+    if (global->hash != hash || !(mod->needed_mask & (1u << global->module)))
+      continue;
+    if (found && found->load_seq < global->load_seq)
+      continue;
+    if (strcmp(modules[global->module]->dynstr + global->name, symbol) == 0)
+      found = global;
+  }
+
+  return found ? found->addr : 0;
+}
+
+typedef struct {
+  uintptr_t link;
+  so_default_dynlib *entry;
+  uintptr_t hooked;
+  int done;
+} so_import;
+
+static int so_dynlib_index_build(so_module *mod, so_default_dynlib *default_dynlib, int num_default_dynlib) {
+  uint32_t size = 1;
+  while (size < num_default_dynlib * 2)
+    size <<= 1;
+
+  mod->dynlib_index = calloc(size, sizeof(uint16_t));
+  if (!mod->dynlib_index)
+    return -1;
+  mod->dynlib_mask = size - 1;
+  mod->default_dynlib = default_dynlib;
+
+  for (int i = 0; i < num_default_dynlib; i++) {
+    uint32_t slot = so_hash((const uint8_t *)default_dynlib[i].symbol) & mod->dynlib_mask;
+    while (mod->dynlib_index[slot])
+      slot = (slot + 1) & mod->dynlib_mask;
+    mod->dynlib_index[slot] = i + 1;
+  }
+
+  return 0;
+}
+
+static void so_dynlib_index_free(so_module *mod) {
+  free(mod->dynlib_index);
+  mod->dynlib_index = NULL;
+  mod->default_dynlib = NULL;
+}
+
+static so_default_dynlib *so_dynlib_index_find(so_module *mod, const char *symbol) {
+  uint32_t slot = so_hash((const uint8_t *)symbol) & mod->dynlib_mask;
+  while (mod->dynlib_index[slot]) {
+    so_default_dynlib *entry = &mod->default_dynlib[mod->dynlib_index[slot] - 1];
+    if (strcmp(symbol, entry->symbol) == 0)
+      return entry;
+    slot = (slot + 1) & mod->dynlib_mask;
+  }
+  return NULL;
+}
+
+static void so_resolve_import(so_module *mod, Elf32_Sym *sym, so_import *import) {
+  if (!mod->default_dynlib_only)
+    import->link = so_resolve_link(mod, mod->dynstr + sym->st_name);
+  import->entry = so_dynlib_index_find(mod, mod->dynstr + sym->st_name);
+  import->done = 1;
+}
+
+static pthread_mutex_t lazy_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void so_lazy_trampoline(void);
+
+// Called from so_lazy_trampoline with the GOT slot that the PLT stub left in ip
+__attribute__((used)) static uintptr_t so_lazy_bind(uintptr_t *slot) {
+  so_module *mod = head;
+  while (mod) {
+    if ((uintptr_t)slot >= mod->data_base && (uintptr_t)slot < mod->data_base + mod->data_size)
+      break;
+    mod = mod->next;
+  }
+
+  int i = -1;
+  if (mod && mod->lazy_index) {
+    uint32_t index = ((uintptr_t)slot - mod->text_base - mod->lazy_base) / sizeof(uint32_t);
+    if (index < mod->num_lazy_index)
+      i = mod->lazy_index[index];
+  }
+
+  if (i < 0)
+    fatal_error("Error lazy binding of unknown slot %p.", slot);
+
+  Elf32_Sym *sym = &mod->dynsym[ELF32_R_SYM(mod->relplt[i].r_info)];
+  so_import import;
+  memset(&import, 0, sizeof(so_import));
+  so_resolve_import(mod, sym, &import);
+
+  uintptr_t func = import.entry ? import.entry->func : import.link;
+  if (!func)
+    fatal_error("Error could not resolve %s.", mod->dynstr + sym->st_name);
+
+  // The hook is applied just like so_resolve does when binding up front. Threads may race to
+  // the same slot, which is fine as long as only one of them runs the hook.
+  if (import.entry && mod->import_hook) {
+    pthread_mutex_lock(&lazy_lock);
+    if (*slot == (uintptr_t)&so_lazy_trampoline)
+      *slot = mod->import_hook(mod, mod->dynstr + sym->st_name, func);
+    func = *slot;
+    pthread_mutex_unlock(&lazy_lock);
+    return func;
+  }
+
+  // debugPrintf("Lazy bound: %s\n", mod->dynstr + sym->st_name);
+  *slot = func;
+  return func;
+}
+
+#ifdef __arm__
+// PLT stubs jump here with ip pointing at the GOT slot and the call arguments untouched
+__attribute__((naked)) static void so_lazy_trampoline(void) {
+  __asm__ volatile (
+    "push {r0-r3, ip, lr}\n"
+    "mov r0, ip\n"
+    "bl so_lazy_bind\n"
+    "str r0, [sp, #16]\n"
+    "pop {r0-r3, ip, lr}\n"
+    "bx ip\n"
+  );
+}
+#else
+// Host builds (tools/loader_bench) never run the image
+static void so_lazy_trampoline(void) {
+  fatal_error("Error lazy binding is not supported on this platform.");
+}
+#endif
+
+// Maps GOT slots straight to their .rel.plt entry. They are usually laid out in JMPREL order, but
+// nothing requires it, so the index doesn't assume it.
+static int so_lazy_index_build(so_module *mod) {
+  uint32_t start = ~0, end = 0;
+
+  for (int i = 0; i < mod->num_relplt; i++) {
+    if (mod->relplt[i].r_offset < start)
+      start = mod->relplt[i].r_offset;
+    if (mod->relplt[i].r_offset > end)
+      end = mod->relplt[i].r_offset;
+  }
+
+  if (start > end)
+    return 0;
+
+  mod->lazy_base = start;
+  mod->num_lazy_index = (end - start) / sizeof(uint32_t) + 1;
+  mod->lazy_index = malloc(mod->num_lazy_index * sizeof(int));
+  if (!mod->lazy_index)
+    return -1;
+
+  memset(mod->lazy_index, 0xff, mod->num_lazy_index * sizeof(int));
+  for (int i = 0; i < mod->num_relplt; i++)
+    mod->lazy_index[(mod->relplt[i].r_offset - start) / sizeof(uint32_t)] = i;
 
   return 0;
 }
 
 int so_resolve(so_module *mod, so_default_dynlib *default_dynlib, int size_default_dynlib, int default_dynlib_only) {
-  uintptr_t val;
+  if (so_dynlib_index_build(mod, default_dynlib, size_default_dynlib / sizeof(so_default_dynlib)) < 0)
+    return -1;
+
+  mod->default_dynlib_only = default_dynlib_only;
+  if (!default_dynlib_only)
+    so_link_needed(mod);
+
+  // Many relocations share the same symbol, so look each one up only once
+  so_import *imports = calloc(mod->num_dynsym, sizeof(so_import));
+  if (!imports) {
+    so_dynlib_index_free(mod);
+    return -1;
+  }
+
   for (int i = 0; i < mod->num_reldyn + mod->num_relplt; i++) {
-    Elf32_Rel *rel = i < mod->num_reldyn ? &mod->reldyn[i] : &mod->relplt[i - mod->num_reldyn];
+    Elf32_Rel *rel = so_rel_at(mod, i);
     Elf32_Sym *sym = &mod->dynsym[ELF32_R_SYM(rel->r_info)];
-    uintptr_t *ptr = (uintptr_t *)(mod->text_base + rel->r_offset);
+    uint32_t *ptr = so_slot(mod, rel->r_offset);
 
     int type = ELF32_R_TYPE(rel->r_info);
     switch (type) {
@@ -299,37 +1468,36 @@ int so_resolve(so_module *mod, so_default_dynlib *default_dynlib, int size_defau
       case R_ARM_JUMP_SLOT:
       {
         if (sym->st_shndx == SHN_UNDEF) {
-          int resolved = 0;
-          if (!default_dynlib_only) {
-            uintptr_t link = so_resolve_link(mod, mod->dynstr + sym->st_name);
-            if (link) {
-              // debugPrintf("Resolved from dependencies: %s\n", mod->dynstr + sym->st_name);
-              if (type == R_ARM_ABS32) {
-                val = *ptr + link;
-                kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
-              } else {
-                val = link;
-                kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
-              }
-              resolved = 1;
-            }
+          if (type == R_ARM_JUMP_SLOT && mod->lazy_bind) {
+            *ptr = (uintptr_t)&so_lazy_trampoline;
+            mod->num_lazy_slots++;
+            break;
           }
 
-          for (int j = 0; j < size_default_dynlib / sizeof(so_default_dynlib); j++) {
-            if (strcmp(mod->dynstr + sym->st_name, default_dynlib[j].symbol) == 0) {
-              if (resolved) {
-                // debugPrintf("Overriden: %s\n", mod->dynstr + sym->st_name);
-              } else {
-                // debugPrintf("Resolved manually: %s\n", mod->dynstr + sym->st_name);
-              }
-              val = default_dynlib[j].func;
-              kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
-              resolved = 1;
-              break;
-            }
-          }
+          so_import *import = &imports[ELF32_R_SYM(rel->r_info)];
+          if (!import->done)
+            so_resolve_import(mod, sym, import);
 
-          if (!resolved) {
+          if (import->entry) {
+            if (import->link) {
+              // debugPrintf("Overriden: %s\n", mod->dynstr + sym->st_name);
+            } else {
+              // debugPrintf("Resolved manually: %s\n", mod->dynstr + sym->st_name);
+            }
+            if (type == R_ARM_JUMP_SLOT && mod->import_hook) {
+              if (!import->hooked)
+                import->hooked = mod->import_hook(mod, mod->dynstr + sym->st_name, import->entry->func);
+              *ptr = import->hooked;
+            } else {
+              *ptr = import->entry->func;
+            }
+          } else if (import->link) {
+            // debugPrintf("Resolved from dependencies: %s\n", mod->dynstr + sym->st_name);
+            if (type == R_ARM_ABS32)
+              *ptr += import->link;
+            else
+              *ptr = import->link;
+          } else {
             // debugPrintf("Missing: %s\n", mod->dynstr + sym->st_name);
           }
         }
@@ -342,6 +1510,130 @@ int so_resolve(so_module *mod, so_default_dynlib *default_dynlib, int size_defau
     }
   }
 
+  free(imports);
+
+  // The lazy binder keeps using the index after boot
+  if (!mod->lazy_bind)
+    so_dynlib_index_free(mod);
+  else if (so_lazy_index_build(mod) < 0)
+    return -1;
+
+  return 0;
+}
+
+int so_lazy_report(so_module *mod, const char *path) {
+  int num_bound = 0;
+
+  SceUID fd = sceIoOpen(path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0777);
+  if (fd < 0)
+    return fd;
+
+  for (int i = 0; i < mod->num_relplt; i++) {
+    uintptr_t *slot = (uintptr_t *)(mod->text_base + mod->relplt[i].r_offset);
+    Elf32_Sym *sym = &mod->dynsym[ELF32_R_SYM(mod->relplt[i].r_info)];
+    if (sym->st_shndx != SHN_UNDEF || *slot == (uintptr_t)&so_lazy_trampoline)
+      continue;
+
+    char line[256];
+    snprintf(line, sizeof(line), "%s\n", mod->dynstr + sym->st_name);
+    sceIoWrite(fd, line, strlen(line));
+    num_bound++;
+  }
+
+  sceIoClose(fd);
+
+  debugPrintf("Lazy binding: %d of %d slots bound\n", num_bound, mod->num_lazy_slots);
+
+  return num_bound;
+}
+
+void so_unload(so_module *mod) {
+  so_module *prev = NULL, *curr = head;
+
+  // Still linked, so that hooks in staged text are reverted in their staged pages
+  so_unhook(mod);
+
+  while (curr && curr != mod) {
+    prev = curr;
+    curr = curr->next;
+  }
+
+  if (curr) {
+    if (prev)
+      prev->next = mod->next;
+    else
+      head = mod->next;
+    if (tail == mod)
+      tail = prev;
+  }
+
+  if (mod->id >= 0 && modules[mod->id] == mod) {
+    so_global_remove(mod);
+    modules[mod->id] = NULL;
+
+    // Dependents keep their resolved pointers, they just stop linking against us
+    for (curr = head; curr; curr = curr->next)
+      curr->needed_mask &= ~(1u << mod->id);
+  }
+
+  so_dynlib_index_free(mod);
+  so_stage_free(mod);
+  free(mod->lazy_index);
+  free(mod->addr_syms);
+  free(mod->symstr);
+  free(mod->relr_sidecar);
+
+  if (mod->data_blockid > 0)
+    sceKernelFreeMemBlock(mod->data_blockid);
+  if (mod->text_blockid > 0)
+    sceKernelFreeMemBlock(mod->text_blockid);
+
+  memset(mod, 0, sizeof(so_module));
+  mod->id = -1;
+}
+
+// Everything boot does between so_load and so_initialize
+int so_link(so_module *mod, so_default_dynlib *default_dynlib, int size_default_dynlib, int default_dynlib_only, const so_pipeline *pipeline) {
+  int res;
+
+  mod->lazy_bind = pipeline->lazy_bind;
+  mod->import_hook = pipeline->import_hook;
+
+  if (pipeline->cache_path && (mod->lazy_bind || mod->import_hook))
+    debugPrintf("Prelink cache skipped, lazy binding and import hooks are linked on every boot\n");
+
+  if (!pipeline->cache_path || so_cache_load(mod, pipeline->cache_path, default_dynlib, size_default_dynlib) < 0) {
+    if (pipeline->relr_path)
+      so_relr_load(mod, pipeline->relr_path);
+    so_relocate(mod);
+    res = so_resolve(mod, default_dynlib, size_default_dynlib, default_dynlib_only);
+    if (res < 0)
+      return res;
+    if (pipeline->cache_path)
+      so_cache_save(mod, pipeline->cache_path, default_dynlib, size_default_dynlib);
+  }
+
+  // Hooks land in staged text pages and are flushed together with the relocations
+  if (pipeline->patch)
+    pipeline->patch(mod);
+
+  return so_commit(mod);
+}
+
+int so_reload(so_module *mod, const char *filename, uintptr_t load_addr, so_default_dynlib *default_dynlib, int size_default_dynlib, int default_dynlib_only, const so_pipeline *pipeline) {
+  int res;
+
+  so_unload(mod);
+
+  res = so_load(mod, filename, load_addr);
+  if (res < 0)
+    return res;
+
+  res = so_link(mod, default_dynlib, size_default_dynlib, default_dynlib_only, pipeline);
+  if (res < 0)
+    return res;
+
+  so_initialize(mod);
   return 0;
 }
 
@@ -352,6 +1644,188 @@ void so_initialize(so_module *mod) {
   }
 }
 
+static void so_cache_header_init(so_module *mod, so_cache_header *hdr, so_default_dynlib *default_dynlib, int size_default_dynlib) {
+  XXH64_CTX ctx;
+
+  memset(hdr, 0, sizeof(so_cache_header));
+  hdr->magic = SO_CACHE_MAGIC;
+  hdr->version = SO_CACHE_VERSION;
+  hdr->so_digest = mod->digest;
+
+  // The image embeds the resolved addresses, so any change to the table must invalidate it
+  xxh64_init(&ctx, 0);
+  for (int i = 0; i < size_default_dynlib / sizeof(so_default_dynlib); i++) {
+    xxh64_update(&ctx, default_dynlib[i].symbol, strlen(default_dynlib[i].symbol) + 1);
+    xxh64_update(&ctx, &default_dynlib[i].func, sizeof(uintptr_t));
+  }
+  hdr->dynlib_digest = xxh64_final(&ctx);
+
+  hdr->text_base = mod->text_base;
+  hdr->text_size = mod->text_size;
+  hdr->data_base = mod->data_base;
+  hdr->data_size = mod->data_size;
+}
+
+// Counts the slots that RELR relocates, and stores their offsets if slots is not NULL
+static int so_relr_slots(so_module *mod, so_cache_slot *slots) {
+  uint32_t base = 0;
+  int num = 0;
+
+  for (int i = 0; i < mod->num_relr; i++) {
+    uint32_t entry = mod->relr[i];
+    if ((entry & 1) == 0) {
+      if (slots)
+        slots[num].offset = entry;
+      num++;
+      base = entry + sizeof(uint32_t);
+    } else {
+      uint32_t where = base;
+      for (entry >>= 1; entry; entry >>= 1, where += sizeof(uint32_t)) {
+        if (entry & 1) {
+          if (slots)
+            slots[num].offset = where;
+          num++;
+        }
+      }
+      base += 31 * sizeof(uint32_t);
+    }
+  }
+
+  return num;
+}
+
+static int so_cache_slot_cmp(const void *a, const void *b) {
+  uint32_t x = ((const so_cache_slot *)a)->offset;
+  uint32_t y = ((const so_cache_slot *)b)->offset;
+  return x < y ? -1 : x > y;
+}
+
+static int so_cache_slot_valid(so_module *mod, uint32_t offset) {
+  uint32_t data_offset = mod->data_base - mod->text_base;
+  if (offset & 3)
+    return 0;
+  if (offset + sizeof(uint32_t) <= mod->text_size)
+    return 1;
+  return offset >= data_offset && offset + sizeof(uint32_t) <= data_offset + mod->data_size;
+}
+
+int so_cache_load(so_module *mod, const char *path, so_default_dynlib *default_dynlib, int size_default_dynlib) {
+  so_cache_header expected, hdr;
+  so_cache_slot *slots = NULL;
+  int res;
+
+  // Lazily bound or hooked imports point at runtime state and are never cached
+  if (!mod->text_pages || mod->lazy_bind || mod->import_hook)
+    return -1;
+
+  so_cache_header_init(mod, &expected, default_dynlib, size_default_dynlib);
+
+  SceUID fd = sceIoOpen(path, SCE_O_RDONLY, 0);
+  if (fd < 0)
+    return fd;
+
+  if (sceIoRead(fd, &hdr, sizeof(so_cache_header)) != sizeof(so_cache_header)) {
+    res = -1;
+    goto err_close;
+  }
+
+  expected.num_slots = hdr.num_slots;
+  if (memcmp(&hdr, &expected, sizeof(so_cache_header)) != 0 ||
+      hdr.num_slots > (mod->text_size + mod->data_size) / sizeof(uint32_t)) {
+    res = -1;
+    goto err_close;
+  }
+
+  size_t size = hdr.num_slots * sizeof(so_cache_slot);
+  slots = malloc(size);
+  if (!slots) {
+    res = -3;
+    goto err_close;
+  }
+
+  if (sceIoRead(fd, slots, size) != size) {
+    res = -2;
+    goto err_close;
+  }
+
+  // Checked before anything is written, a bad cache leaves the image as it was loaded
+  for (int i = 0; i < hdr.num_slots; i++) {
+    if (!so_cache_slot_valid(mod, slots[i].offset)) {
+      res = -2;
+      goto err_close;
+    }
+  }
+
+  for (int i = 0; i < hdr.num_slots; i++)
+    *so_slot(mod, slots[i].offset) = slots[i].value;
+
+  res = 0;
+
+err_close:
+  free(slots);
+  sceIoClose(fd);
+  return res;
+}
+
+// Only the slots of the relocations are saved, since so_load already streamed everything else
+int so_cache_save(so_module *mod, const char *path, so_default_dynlib *default_dynlib, int size_default_dynlib) {
+  so_cache_header hdr;
+  char tmp_path[256];
+  int res = 0;
+
+  if (!mod->text_pages || mod->lazy_bind || mod->import_hook)
+    return -1;
+
+  int num_relr = so_relr_slots(mod, NULL);
+  int num_rel = mod->num_reldyn + mod->num_relplt;
+  so_cache_slot *slots = malloc((num_relr + num_rel) * sizeof(so_cache_slot));
+  if (!slots)
+    return -3;
+
+  so_relr_slots(mod, slots);
+  for (int i = 0; i < num_rel; i++)
+    slots[num_relr + i].offset = so_rel_at(mod, i)->r_offset;
+
+  // Slots that several relocations patch are saved once with their final value
+  qsort(slots, num_relr + num_rel, sizeof(so_cache_slot), so_cache_slot_cmp);
+  int num_slots = 0;
+  for (int i = 0; i < num_relr + num_rel; i++) {
+    if (num_slots > 0 && slots[num_slots - 1].offset == slots[i].offset)
+      continue;
+    slots[num_slots].offset = slots[i].offset;
+    slots[num_slots].value = *(uint32_t *)so_view(mod, slots[i].offset);
+    num_slots++;
+  }
+
+  so_cache_header_init(mod, &hdr, default_dynlib, size_default_dynlib);
+  hdr.num_slots = num_slots;
+
+  // Write to a temporary file first so that an interrupted save is never picked up
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+  SceUID fd = sceIoOpen(tmp_path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0777);
+  if (fd < 0) {
+    free(slots);
+    return fd;
+  }
+
+  size_t size = num_slots * sizeof(so_cache_slot);
+  if (sceIoWrite(fd, &hdr, sizeof(so_cache_header)) != sizeof(so_cache_header) ||
+      sceIoWrite(fd, slots, size) != size)
+    res = -1;
+
+  sceIoClose(fd);
+  free(slots);
+
+  if (res < 0) {
+    sceIoRemove(tmp_path);
+    return res;
+  }
+
+  sceIoRemove(path);
+  return sceIoRename(tmp_path, path);
+}
+
 uint32_t so_hash(const uint8_t *name) {
   uint64_t h = 0, g;
   while (*name) {
@@ -363,26 +1837,114 @@ uint32_t so_hash(const uint8_t *name) {
   return h;
 }
 
-uintptr_t so_symbol(so_module *mod, const char *symbol) {
-  if (mod->hash) {
-    uint32_t hash = so_hash((const uint8_t *)symbol);
-    uint32_t nbucket = mod->hash[0];
-    uint32_t *bucket = &mod->hash[2];
-    uint32_t *chain = &bucket[nbucket];
-    for (int i = bucket[hash % nbucket]; i; i = chain[i]) {
-      if (mod->dynsym[i].st_shndx == SHN_UNDEF)
-        continue;
-      if (mod->dynsym[i].st_info != SHN_UNDEF && strcmp(mod->dynstr + mod->dynsym[i].st_name, symbol) == 0)
-        return mod->text_base + mod->dynsym[i].st_value;
+uint32_t so_gnu_hash(const uint8_t *name) {
+  uint32_t h = 5381;
+  while (*name)
+    h = (h << 5) + h + *name++;
+  return h;
+}
+
+static Elf32_Sym *so_symbol_gnu(so_module *mod, const char *symbol) {
+  uint32_t nbucket = mod->gnu_hash[0];
+  uint32_t symoffset = mod->gnu_hash[1];
+  uint32_t bloom_size = mod->gnu_hash[2];
+  uint32_t bloom_shift = mod->gnu_hash[3];
+  uint32_t *bloom = &mod->gnu_hash[4];
+  uint32_t *bucket = &bloom[bloom_size];
+  uint32_t *chain = &bucket[nbucket];
+
+  uint32_t hash = so_gnu_hash((const uint8_t *)symbol);
+
+  // Most misses are rejected here without touching the buckets
+  uint32_t word = bloom[(hash / 32) % bloom_size];
+  uint32_t mask = (1u << (hash % 32)) | (1u << ((hash >> bloom_shift) % 32));
+  if ((word & mask) != mask)
+    return NULL;
+
+  uint32_t i = bucket[hash % nbucket];
+  if (i < symoffset)
+    return NULL;
+
+  while (1) {
+    uint32_t chain_hash = chain[i - symoffset];
+    if ((hash | 1) == (chain_hash | 1)) {
+      Elf32_Sym *sym = &mod->dynsym[i];
+      if (sym->st_shndx != SHN_UNDEF && sym->st_info != SHN_UNDEF && strcmp(mod->dynstr + sym->st_name, symbol) == 0)
+        return sym;
     }
+    if (chain_hash & 1)
+      break;
+    i++;
   }
 
-  for (int i = 0; i < mod->num_dynsym; i++) {
+  return NULL;
+}
+
+static Elf32_Sym *so_symbol_sysv(so_module *mod, const char *symbol) {
+  uint32_t hash = so_hash((const uint8_t *)symbol);
+  uint32_t nbucket = mod->hash[0];
+  uint32_t *bucket = &mod->hash[2];
+  uint32_t *chain = &bucket[nbucket];
+  for (int i = bucket[hash % nbucket]; i; i = chain[i]) {
     if (mod->dynsym[i].st_shndx == SHN_UNDEF)
       continue;
     if (mod->dynsym[i].st_info != SHN_UNDEF && strcmp(mod->dynstr + mod->dynsym[i].st_name, symbol) == 0)
-      return mod->text_base + mod->dynsym[i].st_value;
+      return &mod->dynsym[i];
   }
+  return NULL;
+}
 
-  return 0;
+uintptr_t so_symbol(so_module *mod, const char *symbol) {
+  Elf32_Sym *sym = NULL;
+
+  if (mod->gnu_hash) {
+    sym = so_symbol_gnu(mod, symbol);
+  } else if (mod->hash) {
+    sym = so_symbol_sysv(mod, symbol);
+  } else {
+    for (int i = 0; i < mod->num_dynsym; i++) {
+      if (mod->dynsym[i].st_shndx == SHN_UNDEF)
+        continue;
+      if (mod->dynsym[i].st_info != SHN_UNDEF && strcmp(mod->dynstr + mod->dynsym[i].st_name, symbol) == 0) {
+        sym = &mod->dynsym[i];
+        break;
+      }
+    }
+  }
+
+  if (!sym)
+    return 0;
+
+  return mod->text_base + sym->st_value;
+}
+
+const char *so_addr2sym(so_module *mod, uintptr_t addr, uint32_t *offset) {
+  if (mod->num_addr_syms == 0 || addr < mod->text_base)
+    return NULL;
+
+  // Return addresses into Thumb code have the low bit set
+  uint32_t vaddr = (addr - mod->text_base) & ~1;
+
+  int lo = 0, hi = mod->num_addr_syms - 1, found = -1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (mod->addr_syms[mid].addr <= vaddr) {
+      found = mid;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  if (found < 0)
+    return NULL;
+
+  so_addr_sym *sym = &mod->addr_syms[found];
+  if (sym->size && vaddr >= sym->addr + sym->size)
+    return NULL;
+
+  if (offset)
+    *offset = vaddr - sym->addr;
+
+  return sym->symtab ? mod->symstr + sym->name : mod->dynstr + sym->name;
 }
@@ -3,53 +3,143 @@
 
 #include <vitasdk.h>
 #include "elf.h"
+#include "xxhash.h"
 
 #define ALIGN_MEM(x, align) (((x) + ((align) - 1)) & ~((align) - 1))
 
+#ifndef SCE_KERNEL_MEMBLOCK_TYPE_USER_RX
+#define SCE_KERNEL_MEMBLOCK_TYPE_USER_RX                 (0x0C20D050)
+#endif
+
+typedef struct {
+  char *symbol;
+  uintptr_t func;
+} so_default_dynlib;
+
+typedef struct {
+  char *symbol;
+  uintptr_t func;
+} so_hook;
+
+// Hook target offsets baked by tools/gen_hook_offsets.py for the image with this digest
+typedef struct {
+  const uint64_t *digest;
+  const uint32_t *offsets;
+  int num_offsets;
+} so_hook_offsets;
+
+typedef struct {
+  uint32_t addr;
+  uint32_t size;
+  uint32_t name;
+  uint32_t symtab;
+} so_addr_sym;
+
+// Bytes that a hook replaced, so that so_unhook can put them back
+typedef struct {
+  uintptr_t addr;
+  uint32_t size;
+  uint8_t orig[12];
+} so_hook_patch;
+
 typedef struct so_module {
   struct so_module *next;
+  int id;
+  uint32_t load_seq;
 
   SceUID text_blockid, data_blockid;
   uintptr_t text_base, data_base;
   size_t text_size, data_size;
 
-  Elf32_Ehdr *ehdr;
-  Elf32_Phdr *phdr;
-  Elf32_Shdr *shdr;
+  uint8_t **text_pages; // writable copies of the text pages that were written to before so_commit
 
   Elf32_Dyn *dynamic;
   Elf32_Sym *dynsym;
   Elf32_Rel *reldyn;
   Elf32_Rel *relplt;
+  uint32_t *relr;
 
   int (** init_array)(void);
   uint32_t *hash;
+  uint32_t *gnu_hash;
 
   int num_dynamic;
   int num_dynsym;
   int num_reldyn;
   int num_relplt;
+  int num_relr;
   int num_init_array;
 
   char *soname;
-  char *shstr;
   char *dynstr;
+
+  so_default_dynlib *default_dynlib;
+  uint16_t *dynlib_index;
+  uint32_t dynlib_mask;
+  int default_dynlib_only;
+
+  uint32_t needed_mask;
+  int indexed;
+
+  int lazy_bind;
+  int num_lazy_slots;
+  int *lazy_index; // .rel.plt entry of each GOT slot from lazy_base on, -1 for the others
+  uint32_t lazy_base;
+  int num_lazy_index;
+
+  so_addr_sym *addr_syms;
+  int num_addr_syms;
+  char *symstr;
+
+  void *relr_sidecar;
+
+  uintptr_t (* import_hook)(struct so_module *mod, const char *symbol, uintptr_t func);
+
+  so_hook_patch *hook_patches;
+  int num_hook_patches, max_hook_patches;
+  int num_trampolines;
+
+  uint64_t digest;
 } so_module;
 
+// Everything so_link does after so_load, kept so that so_reload replays exactly what boot did
 typedef struct {
-  char *symbol;
-  uintptr_t func;
-} so_default_dynlib;
+  const char *relr_path;
+  const char *cache_path;
+  int lazy_bind;
+  uintptr_t (* import_hook)(so_module *mod, const char *symbol, uintptr_t func);
+  void (* patch)(so_module *mod);
+} so_pipeline;
+
+void so_patch_begin(void);
+int so_patch_commit(void);
+void so_patch_write(uintptr_t addr, const void *src, size_t size);
+void so_patch_read(uintptr_t addr, void *dst, size_t size);
 
 void hook_thumb(uintptr_t addr, uintptr_t dst);
 void hook_arm(uintptr_t addr, uintptr_t dst);
 void hook_addr(uintptr_t addr, uintptr_t dst);
+int so_hook_table(so_module *mod, so_hook *hooks, int size_hooks, const so_hook_offsets *offsets);
+void so_unhook(so_module *mod);
+so_module *so_find_module(uintptr_t addr);
 
 void so_flush_caches(so_module *mod);
 int so_load(so_module *mod, const char *filename, uintptr_t load_addr);
+int so_load_apk(so_module *mod, const char *apk_path, const char *entry, uintptr_t load_addr);
 int so_relocate(so_module *mod);
+int so_relr_load(so_module *mod, const char *path);
 int so_resolve(so_module *mod, so_default_dynlib *default_dynlib, int size_default_dynlib, int default_dynlib_only);
+int so_commit(so_module *mod);
+int so_link(so_module *mod, so_default_dynlib *default_dynlib, int size_default_dynlib, int default_dynlib_only, const so_pipeline *pipeline);
+int so_lazy_report(so_module *mod, const char *path);
+void so_unload(so_module *mod);
+int so_reload(so_module *mod, const char *filename, uintptr_t load_addr, so_default_dynlib *default_dynlib, int size_default_dynlib, int default_dynlib_only, const so_pipeline *pipeline);
 void so_initialize(so_module *mod);
+uint32_t so_hash(const uint8_t *name);
+uint32_t so_gnu_hash(const uint8_t *name);
+int so_cache_load(so_module *mod, const char *path, so_default_dynlib *default_dynlib, int size_default_dynlib);
+int so_cache_save(so_module *mod, const char *path, so_default_dynlib *default_dynlib, int size_default_dynlib);
 uintptr_t so_symbol(so_module *mod, const char *symbol);
+const char *so_addr2sym(so_module *mod, uintptr_t addr, uint32_t *offset);
 
 #endif
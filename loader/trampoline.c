@@ -0,0 +1,306 @@
+/* trampoline.c -- wrapping hooks that keep the original function callable
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <vitasdk.h>
+#include <kubridge.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "main.h"
+#include "so_util.h"
+#include "trampoline.h"
+
+#define TRAMPOLINE_POOL_SIZE (64 * 1024)
+#define TRAMPOLINE_MAX_SIZE 128
+
+typedef struct {
+  uint8_t buf[TRAMPOLINE_MAX_SIZE];
+  size_t len;
+} trampoline;
+
+static SceUID pool_blockid = -1;
+static uint8_t *pool_base;
+static size_t pool_used;
+static int pool_live;
+
+static int sign_extend(uint32_t value, int bits) {
+  return (int)(value << (32 - bits)) >> (32 - bits);
+}
+
+static int emit16(trampoline *t, uint16_t value) {
+  if (t->len + sizeof(uint16_t) > TRAMPOLINE_MAX_SIZE)
+    return -1;
+  memcpy(&t->buf[t->len], &value, sizeof(uint16_t));
+  t->len += sizeof(uint16_t);
+  return 0;
+}
+
+static int emit32(trampoline *t, uint32_t value) {
+  if (t->len + sizeof(uint32_t) > TRAMPOLINE_MAX_SIZE)
+    return -1;
+  memcpy(&t->buf[t->len], &value, sizeof(uint32_t));
+  t->len += sizeof(uint32_t);
+  return 0;
+}
+
+// Trampolines start 4-byte aligned, so literal loads only need the position within the buffer
+static int thumb_align(trampoline *t) {
+  if (t->len & 2)
+    return emit16(t, 0xbf00); // NOP
+  return 0;
+}
+
+static int thumb_jump(trampoline *t, uintptr_t target) {
+  if (thumb_align(t) < 0)
+    return -1;
+  emit16(t, 0xf8df); // LDR.W PC, [PC]
+  emit16(t, 0xf000);
+  return emit32(t, target);
+}
+
+static int thumb_call(trampoline *t, uintptr_t target) {
+  if (thumb_align(t) < 0)
+    return -1;
+  emit16(t, 0xf8df); // LDR.W IP, [PC, #4]
+  emit16(t, 0xc004);
+  emit16(t, 0x47e0); // BLX IP
+  emit16(t, 0xe001); // B.N over the literal
+  return emit32(t, target);
+}
+
+static int thumb_load(trampoline *t, int rd, uint32_t value, int deref) {
+  if (thumb_align(t) < 0)
+    return -1;
+  emit16(t, 0xf8df); // LDR.W Rd, [PC, #4]
+  emit16(t, (rd << 12) | 4);
+  emit16(t, 0xe002); // B.N over the literal
+  emit16(t, 0xbf00); // NOP
+  if (emit32(t, value) < 0)
+    return -1;
+  if (deref) {
+    emit16(t, 0xf8d0 | rd); // LDR.W Rd, [Rd]
+    return emit16(t, rd << 12);
+  }
+  return 0;
+}
+
+static int arm_jump(trampoline *t, uintptr_t target) {
+  emit32(t, 0xe51ff004); // LDR PC, [PC, #-0x4]
+  return emit32(t, target);
+}
+
+static int arm_call(trampoline *t, uintptr_t target) {
+  emit32(t, 0xe28fe004); // ADD LR, PC, #4
+  emit32(t, 0xe51ff004); // LDR PC, [PC, #-0x4]
+  return emit32(t, target);
+}
+
+static int arm_load(trampoline *t, int rd, uint32_t value, int deref) {
+  emit32(t, 0xe59f0000 | (rd << 12)); // LDR Rd, [PC]
+  emit32(t, 0xea000000); // B over the literal
+  if (emit32(t, value) < 0)
+    return -1;
+  if (deref)
+    return emit32(t, 0xe5900000 | (rd << 16) | (rd << 12)); // LDR Rd, [Rd]
+  return 0;
+}
+
+static int relocate_thumb16(trampoline *t, uintptr_t pc, uint16_t insn) {
+  uint32_t pc_val = pc + 4;
+
+  if ((insn & 0xf800) == 0x4800) { // LDR Rt, [PC, #imm]
+    return thumb_load(t, (insn >> 8) & 7, (pc_val & ~3) + ((insn & 0xff) << 2), 1);
+  } else if ((insn & 0xf800) == 0xa000) { // ADR Rd, #imm
+    return thumb_load(t, (insn >> 8) & 7, (pc_val & ~3) + ((insn & 0xff) << 2), 0);
+  } else if ((insn & 0xf800) == 0xe000) { // B #imm
+    return thumb_jump(t, (pc_val + sign_extend((insn & 0x7ff) << 1, 12)) | 1);
+  } else if ((insn & 0xf000) == 0xd000 && ((insn >> 8) & 0xf) < 0xe) { // B<cond> #imm
+    return -1;
+  } else if ((insn & 0xf500) == 0xb100) { // CBZ/CBNZ
+    return -1;
+  } else if ((insn & 0xff00) == 0xbf00 && (insn & 0xf)) { // IT
+    return -1;
+  } else if ((insn & 0xfc00) == 0x4400) { // ADD/CMP/MOV/BX with high registers
+    int op = (insn >> 8) & 3;
+    int rdn = ((insn >> 4) & 8) | (insn & 7);
+    if (((insn >> 3) & 0xf) == 15 || (op != 3 && rdn == 15))
+      return -1;
+  }
+
+  return emit16(t, insn);
+}
+
+static int relocate_thumb32(trampoline *t, uintptr_t pc, uint16_t hw1, uint16_t hw2) {
+  uint32_t pc_val = pc + 4;
+
+  if ((hw1 & 0xf800) == 0xf000 && (hw2 & 0x8000)) {
+    uint32_t s = (hw1 >> 10) & 1;
+    uint32_t i1 = !(((hw2 >> 13) & 1) ^ s);
+    uint32_t i2 = !(((hw2 >> 11) & 1) ^ s);
+    int offset = sign_extend((s << 24) | (i1 << 23) | (i2 << 22) | ((hw1 & 0x3ff) << 12) | ((hw2 & 0x7ff) << 1), 25);
+
+    switch (hw2 & 0xd000) {
+      case 0xd000: // BL
+        return thumb_call(t, (pc_val + offset) | 1);
+      case 0xc000: // BLX
+        return thumb_call(t, (pc_val & ~3) + offset);
+      case 0x9000: // B.W
+        return thumb_jump(t, (pc_val + offset) | 1);
+      default: // B<cond>.W
+        return -1;
+    }
+  } else if ((hw1 & 0xff7f) == 0xf85f) { // LDR.W Rt, [PC, #imm]
+    int rt = hw2 >> 12;
+    uint32_t imm = hw2 & 0xfff;
+    if (rt == 15)
+      return -1;
+    return thumb_load(t, rt, (pc_val & ~3) + ((hw1 & 0x80) ? imm : -imm), 1);
+  } else if (((hw1 & 0xfbff) == 0xf20f || (hw1 & 0xfbff) == 0xf2af) && !(hw2 & 0x8000)) { // ADR.W Rd, #imm
+    uint32_t imm = (((hw1 >> 10) & 1) << 11) | (((hw2 >> 12) & 7) << 8) | (hw2 & 0xff);
+    return thumb_load(t, (hw2 >> 8) & 0xf, (pc_val & ~3) + ((hw1 & 0x00a0) ? -imm : imm), 0);
+  } else if ((hw1 & 0xfe1f) == 0xf81f || // LDRB/LDRH/LDRSB/LDRSH/PLD literal
+             (hw1 & 0xfe1f) == 0xec1f || // VLDR/VLDM/LDC literal
+             (hw1 & 0xfe5f) == 0xe85f) { // LDRD literal, LDREX and TBB/TBH with PC
+    return -1;
+  }
+
+  emit16(t, hw1);
+  return emit16(t, hw2);
+}
+
+static int relocate_arm(trampoline *t, uintptr_t pc, uint32_t insn) {
+  uint32_t pc_val = pc + 8;
+  uint32_t cond = insn >> 28;
+
+  if ((insn & 0x0e000000) == 0x0a000000) {
+    int offset = sign_extend(insn & 0xffffff, 24) << 2;
+    if (cond == 0xf) // BLX #imm
+      return arm_call(t, (pc_val + offset + ((insn >> 23) & 2)) | 1);
+    if (cond != 0xe)
+      return -1;
+    if (insn & 0x01000000) // BL
+      return arm_call(t, pc_val + offset);
+    return arm_jump(t, pc_val + offset); // B
+  } else if ((insn & 0x0f7f0000) == 0x051f0000) { // LDR Rt, [PC, #imm]
+    int rt = (insn >> 12) & 0xf;
+    uint32_t imm = insn & 0xfff;
+    if (cond != 0xe || rt == 15)
+      return -1;
+    return arm_load(t, rt, pc_val + ((insn & 0x00800000) ? imm : -imm), 1);
+  } else if ((insn & 0x0fff0000) == 0x028f0000 || (insn & 0x0fff0000) == 0x024f0000) { // ADR Rd, #imm
+    int rd = (insn >> 12) & 0xf;
+    uint32_t rot = ((insn >> 8) & 0xf) * 2;
+    uint32_t imm = ((insn & 0xff) >> rot) | ((insn & 0xff) << ((32 - rot) & 31));
+    if (cond != 0xe || rd == 15)
+      return -1;
+    return arm_load(t, rd, pc_val + ((insn & 0x00400000) ? -imm : imm), 0);
+  } else if (((insn >> 16) & 0xf) == 15 || ((insn >> 12) & 0xf) == 15) {
+    return -1;
+  }
+
+  return emit32(t, insn);
+}
+
+// Copies code into executable memory. Trampolines are counted against the module they belong to,
+// if any, and stay mapped until trampoline_release has been called for every such module.
+uintptr_t trampoline_alloc(so_module *mod, const void *code, size_t size) {
+  if (pool_blockid < 0) {
+    pool_blockid = kuKernelAllocMemBlock("trampoline", SCE_KERNEL_MEMBLOCK_TYPE_USER_RX, TRAMPOLINE_POOL_SIZE, NULL);
+    if (pool_blockid < 0)
+      return 0;
+    sceKernelGetMemBlockBase(pool_blockid, (void **)&pool_base);
+  }
+
+  if (pool_used + size > TRAMPOLINE_POOL_SIZE)
+    return 0;
+
+  // Within a patch transaction, consecutive trampolines are written and flushed together
+  uintptr_t addr = (uintptr_t)pool_base + pool_used;
+  so_patch_write(addr, code, size);
+  pool_used += ALIGN_MEM(size, 4);
+
+  pool_live++;
+  if (mod)
+    mod->num_trampolines++;
+
+  return addr;
+}
+
+// The pool is a bump allocator, so it is only freed as a whole once nothing uses it anymore
+void trampoline_release(so_module *mod) {
+  if (mod->num_trampolines == 0)
+    return;
+
+  pool_live -= mod->num_trampolines;
+  mod->num_trampolines = 0;
+
+  if (pool_live == 0 && pool_blockid >= 0) {
+    sceKernelFreeMemBlock(pool_blockid);
+    pool_blockid = -1;
+    pool_base = NULL;
+    pool_used = 0;
+  }
+}
+
+// Hooks addr like hook_addr, but first moves the overwritten prologue into a trampoline.
+// Returns a pointer that calls the original function, or 0 if the prologue can't be moved.
+uintptr_t hook_wrap(uintptr_t addr, uintptr_t dst) {
+  trampoline t;
+  uintptr_t pc, end, orig;
+
+  if (addr == 0)
+    return 0;
+
+  memset(&t, 0, sizeof(trampoline));
+
+  if (addr & 1) {
+    pc = addr & ~1;
+    end = pc + ((pc & 2) ? 10 : 8); // see hook_thumb
+
+    while (pc < end) {
+      uint16_t hw1, hw2;
+      so_patch_read(pc, &hw1, sizeof(hw1));
+      if ((hw1 >> 11) >= 0x1d) {
+        so_patch_read(pc + 2, &hw2, sizeof(hw2));
+        if (relocate_thumb32(&t, pc, hw1, hw2) < 0)
+          return 0;
+        pc += 4;
+      } else {
+        if (relocate_thumb16(&t, pc, hw1) < 0)
+          return 0;
+        pc += 2;
+      }
+    }
+
+    if (thumb_jump(&t, pc | 1) < 0)
+      return 0;
+
+    orig = trampoline_alloc(so_find_module(addr), t.buf, t.len);
+    if (!orig)
+      return 0;
+    orig |= 1;
+  } else {
+    for (pc = addr, end = addr + 8; pc < end; pc += 4) {
+      uint32_t insn;
+      so_patch_read(pc, &insn, sizeof(insn));
+      if (relocate_arm(&t, pc, insn) < 0)
+        return 0;
+    }
+
+    if (arm_jump(&t, pc) < 0)
+      return 0;
+
+    orig = trampoline_alloc(so_find_module(addr), t.buf, t.len);
+    if (!orig)
+      return 0;
+  }
+
+  hook_addr(addr, dst);
+  return orig;
+}
@@ -0,0 +1,13 @@
+#ifndef __TRAMPOLINE_H__
+#define __TRAMPOLINE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "so_util.h"
+
+uintptr_t trampoline_alloc(so_module *mod, const void *code, size_t size);
+void trampoline_release(so_module *mod);
+uintptr_t hook_wrap(uintptr_t addr, uintptr_t dst);
+
+#endif
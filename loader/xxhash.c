@@ -0,0 +1,154 @@
+/* xxhash.c -- XXH64, a fast non-cryptographic hash
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <string.h>
+
+#include "xxhash.h"
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+// Unaligned little endian reads, the source strings have no alignment
+static inline uint64_t read64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint64_t round64(uint64_t acc, uint64_t input) {
+  acc += input * PRIME64_2;
+  acc = ROTL64(acc, 31);
+  return acc * PRIME64_1;
+}
+
+static inline uint64_t merge64(uint64_t acc, uint64_t val) {
+  acc ^= round64(0, val);
+  return acc * PRIME64_1 + PRIME64_4;
+}
+
+static inline void init_lanes(uint64_t *v, uint64_t seed) {
+  v[0] = seed + PRIME64_1 + PRIME64_2;
+  v[1] = seed + PRIME64_2;
+  v[2] = seed;
+  v[3] = seed - PRIME64_1;
+}
+
+static inline const uint8_t *stripes(uint64_t *v, const uint8_t *p, const uint8_t *end) {
+  do {
+    v[0] = round64(v[0], read64(p));
+    v[1] = round64(v[1], read64(p + 8));
+    v[2] = round64(v[2], read64(p + 16));
+    v[3] = round64(v[3], read64(p + 24));
+    p += 32;
+  } while (p + 32 <= end);
+  return p;
+}
+
+static inline uint64_t converge(const uint64_t *v) {
+  uint64_t h = ROTL64(v[0], 1) + ROTL64(v[1], 7) + ROTL64(v[2], 12) + ROTL64(v[3], 18);
+  h = merge64(h, v[0]);
+  h = merge64(h, v[1]);
+  h = merge64(h, v[2]);
+  h = merge64(h, v[3]);
+  return h;
+}
+
+// Mixes in the last bytes, which don't fill a stripe, and avalanches
+static uint64_t finalize(uint64_t h, const uint8_t *p, const uint8_t *end) {
+  for (; p + 8 <= end; p += 8) {
+    h ^= round64(0, read64(p));
+    h = ROTL64(h, 27) * PRIME64_1 + PRIME64_4;
+  }
+
+  if (p + 4 <= end) {
+    h ^= (uint64_t)read32(p) * PRIME64_1;
+    h = ROTL64(h, 23) * PRIME64_2 + PRIME64_3;
+    p += 4;
+  }
+
+  for (; p < end; p++) {
+    h ^= *p * PRIME64_5;
+    h = ROTL64(h, 11) * PRIME64_1;
+  }
+
+  h ^= h >> 33;
+  h *= PRIME64_2;
+  h ^= h >> 29;
+  h *= PRIME64_3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+uint64_t xxh64(const void *data, size_t len, uint64_t seed) {
+  const uint8_t *p = data;
+  const uint8_t *end = p + len;
+  uint64_t h;
+
+  if (len >= 32) {
+    uint64_t v[4];
+    init_lanes(v, seed);
+    p = stripes(v, p, end);
+    h = converge(v);
+  } else {
+    h = seed + PRIME64_5;
+  }
+
+  return finalize(h + len, p, end);
+}
+
+void xxh64_init(XXH64_CTX *ctx, uint64_t seed) {
+  memset(ctx, 0, sizeof(XXH64_CTX));
+  ctx->seed = seed;
+  init_lanes(ctx->v, seed);
+}
+
+// Streaming gives the same hash as xxh64 over the concatenated data
+void xxh64_update(XXH64_CTX *ctx, const void *data, size_t len) {
+  const uint8_t *p = data;
+  const uint8_t *end = p + len;
+
+  ctx->total_len += len;
+
+  if (ctx->memsize + len < 32) {
+    memcpy(ctx->mem + ctx->memsize, p, len);
+    ctx->memsize += len;
+    return;
+  }
+
+  if (ctx->memsize) {
+    memcpy(ctx->mem + ctx->memsize, p, 32 - ctx->memsize);
+    stripes(ctx->v, ctx->mem, ctx->mem + 32);
+    p += 32 - ctx->memsize;
+    ctx->memsize = 0;
+  }
+
+  if (p + 32 <= end)
+    p = stripes(ctx->v, p, end);
+
+  if (p < end) {
+    memcpy(ctx->mem, p, end - p);
+    ctx->memsize = end - p;
+  }
+}
+
+uint64_t xxh64_final(XXH64_CTX *ctx) {
+  uint64_t h = ctx->total_len >= 32 ? converge(ctx->v) : ctx->seed + PRIME64_5;
+  return finalize(h + ctx->total_len, ctx->mem, ctx->mem + ctx->memsize);
+}
@@ -0,0 +1,20 @@
+#ifndef __XXHASH_H__
+#define __XXHASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  uint64_t total_len;
+  uint64_t seed;
+  uint64_t v[4];
+  uint8_t mem[32];
+  uint32_t memsize;
+} XXH64_CTX;
+
+uint64_t xxh64(const void *data, size_t len, uint64_t seed);
+void xxh64_init(XXH64_CTX *ctx, uint64_t seed);
+void xxh64_update(XXH64_CTX *ctx, const void *data, size_t len);
+uint64_t xxh64_final(XXH64_CTX *ctx);
+
+#endif
@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+# gen_hook_offsets.py -- bake hook target offsets for one libTheConduit.so
+#
+# Copyright (C) 2023 Andy Nguyen
+#
+# This software may be modified and distributed under the terms
+# of the MIT license.  See the LICENSE file for details.
+#
+# Usage: tools/gen_hook_offsets.py [libTheConduit.so]
+#
+# Collects every `static so_hook name[]` table in loader/*.c and writes
+# loader/hook_offsets.c/.h with the offset of each hook target in the given
+# library. so_hook_table only uses the offsets if the XXH64 image digest that
+# so_load computes matches, otherwise it falls back to looking up names.
+# Without an argument, empty tables are written that never match.
+
+import glob
+import os
+import re
+import struct
+import sys
+
+from xxh64 import xxh64
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+
+PT_LOAD = 1
+PT_DYNAMIC = 2
+DT_NULL = 0
+DT_HASH = 4
+DT_STRTAB = 5
+DT_SYMTAB = 6
+DT_GNU_HASH = 0x6ffffef5
+
+
+def elf_hash(name):
+  h = 0
+  for c in name.encode():
+    h = ((h << 4) + c) & 0xffffffff
+    g = h & 0xf0000000
+    if g:
+      h ^= g >> 24
+    h &= 0x0fffffff
+  return h
+
+
+def dl_new_hash(name):
+  h = 5381
+  for c in name.encode():
+    h = (h * 33 + c) & 0xffffffff
+  return h
+
+
+def parse_hook_tables():
+  tables = []
+  for path in sorted(glob.glob(os.path.join(ROOT, 'loader', '*.c'))):
+    with open(path) as f:
+      source = f.read()
+    for match in re.finditer(r'static so_hook (\w+)\[\] = \{(.*?)\n\};', source, re.S):
+      symbols = []
+      for line in match.group(2).splitlines():
+        entry = re.match(r'\s*\{ "([^"]+)"', line)
+        if entry:
+          symbols.append(entry.group(1))
+      tables.append((match.group(1), symbols))
+  return tables
+
+
+class Image:
+  def __init__(self, path):
+    with open(path, 'rb') as f:
+      self.data = f.read()
+
+    if self.data[:4] != b'\x7fELF' or self.data[4] != 1:
+      sys.exit('Error %s is not an ELF32 image' % path)
+
+    e_phoff, = struct.unpack_from('<I', self.data, 28)
+    e_phnum, = struct.unpack_from('<H', self.data, 44)
+    self.phdrs = [struct.unpack_from('<8I', self.data, e_phoff + i * 32) for i in range(e_phnum)]
+
+    # Same digest as so_load: ELF header, program headers and the file contents of every PT_LOAD
+    parts = [self.data[:52], self.data[e_phoff:e_phoff + e_phnum * 32]]
+    for p_type, p_offset, p_vaddr, p_paddr, p_filesz, p_memsz, p_flags, p_align in self.phdrs:
+      if p_type == PT_LOAD:
+        parts.append(self.data[p_offset:p_offset + p_filesz])
+    self.digest = xxh64(b''.join(parts))
+
+    self.parse_dynamic()
+
+  def offset(self, vaddr):
+    for p_type, p_offset, p_vaddr, p_paddr, p_filesz, p_memsz, p_flags, p_align in self.phdrs:
+      if p_type == PT_LOAD and p_vaddr <= vaddr < p_vaddr + p_filesz:
+        return p_offset + vaddr - p_vaddr
+    sys.exit('Error address 0x%x is not backed by the file' % vaddr)
+
+  def u32(self, vaddr):
+    return struct.unpack_from('<I', self.data, self.offset(vaddr))[0]
+
+  def parse_dynamic(self):
+    tags = {}
+    for p_type, p_offset, p_vaddr, p_paddr, p_filesz, p_memsz, p_flags, p_align in self.phdrs:
+      if p_type == PT_DYNAMIC:
+        for i in range(p_filesz // 8):
+          d_tag, d_val = struct.unpack_from('<2I', self.data, p_offset + i * 8)
+          if d_tag == DT_NULL:
+            break
+          tags[d_tag] = d_val
+
+    self.tags = tags
+    self.symtab = tags[DT_SYMTAB]
+    self.strtab = tags[DT_STRTAB]
+
+    # Mirrors how so_load derives the symbol count
+    if DT_HASH in tags:
+      self.num_syms = self.u32(tags[DT_HASH] + 4)
+    elif DT_GNU_HASH in tags:
+      gnu_hash = tags[DT_GNU_HASH]
+      nbucket, symoffset, bloom_size = self.u32(gnu_hash), self.u32(gnu_hash + 4), self.u32(gnu_hash + 8)
+      buckets = gnu_hash + 16 + bloom_size * 4
+      chains = buckets + nbucket * 4
+      last = max([self.u32(buckets + i * 4) for i in range(nbucket)] + [0])
+      if last >= symoffset:
+        while (self.u32(chains + (last - symoffset) * 4) & 1) == 0:
+          last += 1
+        self.num_syms = last + 1
+      else:
+        self.num_syms = symoffset
+    else:
+      self.num_syms = (self.strtab - self.symtab) // 16
+
+  def symbol(self, i):
+    st_name, st_value, st_size, st_info, st_other, st_shndx = struct.unpack_from('<3I2BH', self.data, self.offset(self.symtab + i * 16))
+    start = self.offset(self.strtab + st_name)
+    name = self.data[start:self.data.index(b'\0', start)].decode()
+    return name, st_value, st_info, st_shndx
+
+  def defines(self, i, name):
+    sym_name, st_value, st_info, st_shndx = self.symbol(i)
+    return st_shndx != 0 and st_info != 0 and sym_name == name
+
+  def lookup_gnu(self, name):
+    gnu_hash = self.tags[DT_GNU_HASH]
+    nbucket, symoffset, bloom_size, bloom_shift = [self.u32(gnu_hash + i * 4) for i in range(4)]
+    bloom = gnu_hash + 16
+    buckets = bloom + bloom_size * 4
+    chains = buckets + nbucket * 4
+
+    h = dl_new_hash(name)
+    word = self.u32(bloom + ((h // 32) % bloom_size) * 4)
+    mask = (1 << (h % 32)) | (1 << ((h >> bloom_shift) % 32))
+    if word & mask != mask:
+      return None
+
+    i = self.u32(buckets + (h % nbucket) * 4)
+    if i < symoffset:
+      return None
+    while True:
+      chain_hash = self.u32(chains + (i - symoffset) * 4)
+      if (h | 1) == (chain_hash | 1) and self.defines(i, name):
+        return i
+      if chain_hash & 1:
+        return None
+      i += 1
+
+  def lookup_sysv(self, name):
+    hash_table = self.tags[DT_HASH]
+    nbucket = self.u32(hash_table)
+    buckets = hash_table + 8
+    chains = buckets + nbucket * 4
+    i = self.u32(buckets + (elf_hash(name) % nbucket) * 4)
+    while i:
+      if self.defines(i, name):
+        return i
+      i = self.u32(chains + i * 4)
+    return None
+
+  # The definition that so_symbol returns, the first one its hash chain reaches
+  def lookup(self, name):
+    if DT_GNU_HASH in self.tags:
+      i = self.lookup_gnu(name)
+    elif DT_HASH in self.tags:
+      i = self.lookup_sysv(name)
+    else:
+      i = next((i for i in range(self.num_syms) if self.defines(i, name)), None)
+    return self.symbol(i)[1] if i is not None else 0
+
+
+def main():
+  tables = parse_hook_tables()
+  image = Image(sys.argv[1]) if len(sys.argv) > 1 else None
+
+  with open(os.path.join(ROOT, 'loader', 'hook_offsets.h'), 'w') as f:
+    f.write('// Generated by tools/gen_hook_offsets.py, do not edit\n\n')
+    f.write('#ifndef __HOOK_OFFSETS_H__\n#define __HOOK_OFFSETS_H__\n\n#include "so_util.h"\n\n')
+    for name, symbols in tables:
+      f.write('extern const so_hook_offsets %s_offsets;\n' % name)
+    f.write('\n#endif\n')
+
+  with open(os.path.join(ROOT, 'loader', 'hook_offsets.c'), 'w') as f:
+    if image:
+      f.write('// Generated by tools/gen_hook_offsets.py from %s, do not edit\n\n' % os.path.basename(sys.argv[1]))
+    else:
+      f.write('// Generated by tools/gen_hook_offsets.py without a library, do not edit\n\n')
+    f.write('#include <stddef.h>\n\n#include "hook_offsets.h"\n')
+
+    if not image:
+      f.write('\n')
+      for name, symbols in tables:
+        f.write('const so_hook_offsets %s_offsets = { NULL, NULL, 0 };\n' % name)
+      return
+
+    f.write('\nstatic const uint64_t digest = 0x%016xULL;\n' % image.digest)
+
+    for name, symbols in tables:
+      f.write('\nstatic const uint32_t %s_table[] = {\n' % name)
+      for symbol in symbols:
+        # 0 is never a valid function, so_hook_table reports it as missing
+        value = image.lookup(symbol)
+        f.write('  0x%08x, // %s%s\n' % (value, symbol, '' if value else ' (missing)'))
+      f.write('};\n\n')
+      f.write('const so_hook_offsets %s_offsets = { &digest, %s_table, %d };\n' % (name, name, len(symbols)))
+
+
+if __name__ == '__main__':
+  main()
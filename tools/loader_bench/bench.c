@@ -0,0 +1,284 @@
+/* bench.c -- host benchmark for the so_util.c load and link phases
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <vitasdk.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "so_util.h"
+#include "xxhash.h"
+
+#define BENCH_LOAD_ADDRESS 0x98000000
+#define BENCH_DEP_ADDRESS 0x90000000
+#define BENCH_DEP_STRIDE 0x01000000
+#define BENCH_MAX_DEPS 16
+
+enum {
+  PHASE_LOAD,
+  PHASE_RELOCATE,
+  PHASE_RESOLVE,
+  PHASE_COMMIT,
+  PHASE_SYMBOL,
+  PHASE_MISS,
+  PHASE_ADDR2SYM,
+  NUM_PHASES,
+};
+
+static const char *phase_names[NUM_PHASES] = {
+  "so_load",
+  "so_relocate",
+  "so_resolve",
+  "so_commit",
+  "so_symbol",
+  "so_sym_miss",
+  "so_addr2sym",
+};
+
+static so_module deps[BENCH_MAX_DEPS];
+static so_module mod;
+
+static int dummy_func(void) {
+  return 0;
+}
+
+// Stands in for the default_dynlib table of main.c, covering every other import
+static so_default_dynlib *make_dynlib(so_module *mod, int *size) {
+  so_default_dynlib *dynlib = calloc(mod->num_dynsym, sizeof(so_default_dynlib));
+  int num = 0;
+
+  for (int i = 1; i < mod->num_dynsym; i += 2) {
+    if (mod->dynsym[i].st_shndx != SHN_UNDEF)
+      continue;
+    dynlib[num].symbol = strdup(mod->dynstr + mod->dynsym[i].st_name);
+    dynlib[num].func = (uintptr_t)&dummy_func;
+    num++;
+  }
+
+  *size = num * sizeof(so_default_dynlib);
+  return dynlib;
+}
+
+static uint64_t image_hash(so_module *mod) {
+  uint64_t h = xxh64((void *)mod->text_base, mod->text_size, 0);
+  return xxh64((void *)mod->data_base, mod->data_size, h);
+}
+
+static int load_image(so_module *mod, const char *path) {
+  if (so_load(mod, path, BENCH_LOAD_ADDRESS) < 0) {
+    printf("Error could not load %s\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+// Lookups that have to fail: every import of the module plus made up names of the same shape
+// as its exports, so the bloom filter and the bucket chains are measured on the miss path too
+static char **make_misses(so_module *mod, int *num) {
+  char **misses = calloc(mod->num_dynsym * 2, sizeof(char *));
+  int n = 0;
+
+  srand(1);
+
+  for (int i = 1; i < mod->num_dynsym; i++) {
+    const char *name = mod->dynstr + mod->dynsym[i].st_name;
+    if (mod->dynsym[i].st_shndx == SHN_UNDEF) {
+      misses[n++] = strdup(name);
+      continue;
+    }
+
+    char *random = strdup(name);
+    for (char *c = random; *c; c++)
+      *c = 'a' + rand() % 26;
+    if (!so_symbol(mod, random))
+      misses[n++] = random;
+    else
+      free(random);
+  }
+
+  *num = n;
+  return misses;
+}
+
+int main(int argc, char *argv[]) {
+  const char *relr_path = NULL;
+  int iterations = 10, opt;
+  SceUInt64 total[NUM_PHASES], best[NUM_PHASES];
+
+  while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+    switch (opt) {
+      case 'n':
+        iterations = atoi(optarg);
+        break;
+      case 'r':
+        relr_path = optarg;
+        break;
+      default:
+        printf("Usage: %s [-n iterations] [-r libbench.relr] libbench.so [libdep.so...]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if (optind >= argc || argc - optind - 1 > BENCH_MAX_DEPS) {
+    printf("Usage: %s [-n iterations] [-r libbench.relr] libbench.so [libdep.so...]\n", argv[0]);
+    return 1;
+  }
+
+  const char *path = argv[optind];
+  int num_deps = argc - optind - 1;
+
+  // Dependencies are loaded once, only the main image is measured
+  for (int i = 0; i < num_deps; i++) {
+    if (so_load(&deps[i], argv[optind + 1 + i], BENCH_DEP_ADDRESS + i * BENCH_DEP_STRIDE) < 0) {
+      printf("Error could not load %s\n", argv[optind + 1 + i]);
+      return 1;
+    }
+    so_relocate(&deps[i]);
+    so_resolve(&deps[i], NULL, 0, 1);
+    so_commit(&deps[i]);
+  }
+
+  // Reference that every measured iteration has to reproduce byte for byte. It is linked from the
+  // image's own relocation tables, so a sidecar has to come out the same as well.
+  if (load_image(&mod, path) < 0)
+    return 1;
+
+  int size_dynlib, num_misses;
+  so_default_dynlib *dynlib = make_dynlib(&mod, &size_dynlib);
+  char **misses = make_misses(&mod, &num_misses);
+
+  char cache_path[256];
+  snprintf(cache_path, sizeof(cache_path), "%s.cache", path);
+
+  so_relocate(&mod);
+  so_resolve(&mod, dynlib, size_dynlib, 0);
+  if (so_cache_save(&mod, cache_path, dynlib, size_dynlib) < 0) {
+    printf("Error could not save %s\n", cache_path);
+    return 1;
+  }
+  so_commit(&mod);
+  uint64_t reference = image_hash(&mod);
+  so_unload(&mod);
+
+  // A prelinked image must come out the same as one that was linked from scratch
+  if (load_image(&mod, path) < 0)
+    return 1;
+
+  SceUInt64 t_cache = sceKernelGetProcessTimeWide();
+  int res = so_cache_load(&mod, cache_path, dynlib, size_dynlib);
+  t_cache = sceKernelGetProcessTimeWide() - t_cache;
+
+  if (res < 0) {
+    printf("Error could not load %s: %d\n", cache_path, res);
+    return 1;
+  }
+  so_commit(&mod);
+  if (image_hash(&mod) != reference) {
+    printf("Error prelinked image differs from the linked one\n");
+    return 1;
+  }
+  int image_size = mod.text_size + mod.data_size;
+  so_unload(&mod);
+
+  SceUID cache_fd = sceIoOpen(cache_path, SCE_O_RDONLY, 0);
+  int cache_size = sceIoLseek(cache_fd, 0, SCE_SEEK_END);
+  sceIoClose(cache_fd);
+  sceIoRemove(cache_path);
+
+  for (int i = 0; i < NUM_PHASES; i++) {
+    total[i] = 0;
+    best[i] = ~0ULL;
+  }
+
+  for (int n = 0; n < iterations; n++) {
+    SceUInt64 t[NUM_PHASES + 1];
+    int lookups = 0;
+
+    t[0] = sceKernelGetProcessTimeWide();
+
+    if (so_load(&mod, path, BENCH_LOAD_ADDRESS) < 0) {
+      printf("Error could not load %s\n", path);
+      return 1;
+    }
+
+    t[1] = sceKernelGetProcessTimeWide();
+
+    if (relr_path && so_relr_load(&mod, relr_path) < 0) {
+      printf("Error could not load %s\n", relr_path);
+      return 1;
+    }
+    so_relocate(&mod);
+
+    t[2] = sceKernelGetProcessTimeWide();
+
+    so_resolve(&mod, dynlib, size_dynlib, 0);
+
+    t[3] = sceKernelGetProcessTimeWide();
+
+    so_commit(&mod);
+
+    t[4] = sceKernelGetProcessTimeWide();
+
+    for (int i = 1; i < mod.num_dynsym; i++) {
+      if (mod.dynsym[i].st_shndx == SHN_UNDEF)
+        continue;
+      if (!so_symbol(&mod, mod.dynstr + mod.dynsym[i].st_name)) {
+        printf("Error could not find %s\n", mod.dynstr + mod.dynsym[i].st_name);
+        return 1;
+      }
+      lookups++;
+    }
+
+    t[5] = sceKernelGetProcessTimeWide();
+
+    for (int i = 0; i < num_misses; i++) {
+      if (so_symbol(&mod, misses[i])) {
+        printf("Error unexpectedly found %s\n", misses[i]);
+        return 1;
+      }
+    }
+
+    t[6] = sceKernelGetProcessTimeWide();
+
+    for (int i = 1; i < mod.num_dynsym; i++) {
+      uint32_t offset;
+      if (mod.dynsym[i].st_shndx != SHN_UNDEF)
+        so_addr2sym(&mod, mod.text_base + mod.dynsym[i].st_value + 2, &offset);
+    }
+
+    t[7] = sceKernelGetProcessTimeWide();
+
+    if (image_hash(&mod) != reference) {
+      printf("Error image differs from the reference in iteration %d\n", n);
+      return 1;
+    }
+
+    for (int i = 0; i < NUM_PHASES; i++) {
+      SceUInt64 elapsed = t[i + 1] - t[i];
+      total[i] += elapsed;
+      if (elapsed < best[i])
+        best[i] = elapsed;
+    }
+
+    if (n == 0)
+      printf("%s: %d symbols, %d relocations, %d lookups, %d misses\n\n",
+             path, mod.num_dynsym, mod.num_reldyn + mod.num_relplt + mod.num_relr, lookups, num_misses);
+
+    so_unload(&mod);
+  }
+
+  printf("%-12s %10s %10s\n", "phase", "best us", "avg us");
+  for (int i = 0; i < NUM_PHASES; i++)
+    printf("%-12s %10llu %10llu\n", phase_names[i], best[i], total[i] / iterations);
+  printf("\nso_cache_load replaced relocate and resolve in %llu us, reading %d bytes for a %d byte image\n",
+         t_cache, cache_size, image_size);
+
+  return 0;
+}
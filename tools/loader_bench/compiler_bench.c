@@ -0,0 +1,130 @@
+/* compiler_bench.c -- drives the background shader compiler with the mock backend
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <vitasdk.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "glsl_translate.h"
+#include "shader_compiler.h"
+#include "xxhash.h"
+
+extern shader_compiler shader_compiler_mock;
+extern int mock_compile_us_per_kb;
+
+// Looks up a shader the way the GL thread does and checks that the GXP holds the Cg of its source
+static int serve(const char *source, uint64_t hash, int length) {
+  int size, cg_length;
+  char *gxp = shader_compiler_lookup(hash, length, &size);
+  if (!gxp)
+    return 1;
+
+  char *cg = glsl_translate(source, length, 1, &cg_length);
+  int res = cg && size == cg_length + 8 && memcmp(gxp + 8, cg, cg_length) == 0 ? 0 : -1;
+  free(cg);
+  return res;
+}
+
+// Plays the game thread: every shader is requested once, dummies are swapped as compiles finish
+int main(int argc, char *argv[]) {
+  int num_shaders = 64, opt;
+  const char *dir = "overlay";
+
+  while ((opt = getopt(argc, argv, "n:d:c:")) != -1) {
+    switch (opt) {
+      case 'n':
+        num_shaders = atoi(optarg);
+        break;
+      case 'd':
+        dir = optarg;
+        break;
+      case 'c':
+        mock_compile_us_per_kb = atoi(optarg);
+        break;
+      default:
+        printf("Usage: %s [-n shaders] [-d overlay dir] [-c us per KB]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  char **sources = malloc(num_shaders * sizeof(char *));
+  uint64_t *hashes = malloc(num_shaders * sizeof(uint64_t));
+  SceUInt64 *served = calloc(num_shaders, sizeof(SceUInt64));
+
+  for (int i = 0; i < num_shaders; i++) {
+    int length = 512 + (i * 997) % 4096;
+    sources[i] = malloc(length + 1);
+    int n = snprintf(sources[i], length + 1, "// shader %d\nvoid main() { gl_FragColor = vec4(%d.0); }\n", i, i);
+    memset(sources[i] + n, ' ', length - n);
+    sources[i][length] = '\0';
+    hashes[i] = xxh64(sources[i], length, 0);
+  }
+
+  SceUInt64 start = sceKernelGetProcessTimeWide();
+  if (shader_compiler_start(&shader_compiler_mock, dir) < 0) {
+    printf("Error could not start the shader compiler\n");
+    return 1;
+  }
+
+  int num_served = 0, num_dummy = 0, num_cached = 0, frames = 0;
+
+  // The first frame requests every shader like glShaderSourceHook, later ones only swap in what
+  // shader_compiler_ready reports, like shader_swap_ready does between frames
+  for (int i = 0; i < num_shaders; i++) {
+    int length = strlen(sources[i]);
+    if (serve(sources[i], hashes[i], length) == 0) {
+      served[i] = sceKernelGetProcessTimeWide() - start;
+      num_cached++;
+      num_served++;
+    } else {
+      shader_compiler_queue(hashes[i], length, sources[i], 1);
+    }
+  }
+
+  while (num_served < num_shaders) {
+    uint64_t hash;
+    uint32_t length;
+
+    frames++;
+    num_dummy += num_shaders - num_served;
+    usleep(16666);
+
+    while (shader_compiler_ready(&hash, &length)) {
+      int i = 0;
+      while (i < num_shaders && (hashes[i] != hash || strlen(sources[i]) != length))
+        i++;
+      if (i == num_shaders || served[i]) {
+        printf("Error shader %016llx_%08x reported more than once\n", (unsigned long long)hash, length);
+        return 1;
+      }
+      if (serve(sources[i], hash, length) < 0) {
+        printf("Error shader %d does not match its source\n", i);
+        return 1;
+      }
+      served[i] = sceKernelGetProcessTimeWide() - start;
+      num_served++;
+    }
+  }
+
+  SceUInt64 total = 0, worst = 0;
+  for (int i = 0; i < num_shaders; i++) {
+    total += served[i];
+    if (served[i] > worst)
+      worst = served[i];
+  }
+
+  printf("%d shaders: %d from the overlay, %d dummy frames, %d frames\n",
+         num_shaders, num_cached, num_dummy, frames);
+  printf("time to real shader: avg %llu us, worst %llu us\n", total / num_shaders, worst);
+
+  shader_compiler_stop();
+  return 0;
+}
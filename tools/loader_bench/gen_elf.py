@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+# gen_elf.py -- generate synthetic ARM ELF32 shared objects for loader_bench
+#
+# Copyright (C) 2023 Andy Nguyen
+#
+# This software may be modified and distributed under the terms
+# of the MIT license.  See the LICENSE file for details.
+#
+# Writes libbench.so plus one libdepN.so per DT_NEEDED entry. Imports are
+# spread over the dependencies, so resolution exercises both default_dynlib
+# and the cross-module symbol index. The images are only ever loaded and
+# linked, never run, so functions are a single BX LR.
+
+import argparse
+import os
+import random
+import struct
+
+PAGE = 0x1000
+
+DT_NULL = 0
+DT_NEEDED = 1
+DT_PLTRELSZ = 2
+DT_HASH = 4
+DT_STRTAB = 5
+DT_SYMTAB = 6
+DT_STRSZ = 10
+DT_SYMENT = 11
+DT_SONAME = 14
+DT_REL = 17
+DT_RELSZ = 18
+DT_RELENT = 19
+DT_PLTREL = 20
+DT_JMPREL = 23
+DT_GNU_HASH = 0x6ffffef5
+
+R_ARM_ABS32 = 2
+R_ARM_GLOB_DAT = 21
+R_ARM_JUMP_SLOT = 22
+R_ARM_RELATIVE = 23
+
+
+def align(x, a):
+  return (x + a - 1) & ~(a - 1)
+
+
+def sysv_hash(name):
+  h = 0
+  for c in name.encode():
+    h = ((h << 4) + c) & 0xffffffff
+    g = h & 0xf0000000
+    if g:
+      h ^= g >> 24
+    h &= ~g & 0xffffffff
+  return h
+
+
+def gnu_hash(name):
+  h = 5381
+  for c in name.encode():
+    h = (h * 33 + c) & 0xffffffff
+  return h
+
+
+class Strtab:
+  def __init__(self):
+    self.data = bytearray(b'\0')
+    self.offsets = {}
+
+  def add(self, s):
+    if s not in self.offsets:
+      self.offsets[s] = len(self.data)
+      self.data += s.encode() + b'\0'
+    return self.offsets[s]
+
+
+def build(soname, exports, imports, needed, num_relocs, mix, hash_type, rng, shared=0.0):
+  nbucket = max(1, len(exports) // 2) | 1
+
+  # GNU hash wants the defined symbols last, grouped by bucket
+  if hash_type in ('gnu', 'both'):
+    exports = sorted(exports, key=lambda n: gnu_hash(n) % nbucket)
+  names = [''] + imports + exports
+  symoffset = 1 + len(imports)
+
+  dynstr = Strtab()
+  needed_offsets = [dynstr.add(n) for n in needed]
+  soname_offset = dynstr.add(soname)
+  name_offsets = [dynstr.add(n) if n else 0 for n in names]
+
+  # Relocation kinds, drawn from the requested mix
+  kinds = rng.choices(['relative', 'abs32', 'glob_dat', 'jump_slot'], weights=mix, k=num_relocs)
+  rel_kinds = [k for k in kinds if k != 'jump_slot']
+  plt_kinds = [k for k in kinds if k == 'jump_slot'] if imports else []
+
+  # Text segment layout: headers, dynsym, dynstr, hash tables, relocations, code
+  num_phdr = 3
+  off = 52 + num_phdr * 32
+  dynsym_off = off
+  off += len(names) * 16
+  dynstr_off = off
+  off = align(off + len(dynstr.data), 4)
+
+  hash_off = gnu_off = None
+  if hash_type in ('sysv', 'both'):
+    hash_off = off
+    off += (2 + nbucket + len(names)) * 4
+  if hash_type in ('gnu', 'both'):
+    # Sized like lld does, about 12 bits per export, otherwise the filter rejects almost no misses
+    bloom_size = 1 << max(0, (len(exports) * 12 // 32 - 1).bit_length())
+    gnu_off = off
+    off += (4 + bloom_size + nbucket + len(exports)) * 4
+
+  rel_off = off
+  off += len(rel_kinds) * 8
+  plt_off = off
+  off += len(plt_kinds) * 8
+  text_off = off
+  off += len(exports) * 4
+  text_size = off
+
+  # Data segment: dynamic, then one slot per relocation
+  data_vaddr = align(text_size, PAGE)
+  num_dyn = len(needed) + 14
+  dynamic_vaddr = data_vaddr
+  slots_vaddr = dynamic_vaddr + num_dyn * 8
+  data_size = (slots_vaddr - data_vaddr) + num_relocs * 4
+
+  image = bytearray(data_vaddr + data_size)
+
+  export_addr = {}
+  for i, name in enumerate(exports):
+    export_addr[name] = text_off + i * 4
+    struct.pack_into('<I', image, text_off + i * 4, 0xe12fff1e)  # BX LR
+
+  # dynsym
+  for i, name in enumerate(names):
+    if i == 0:
+      continue
+    if i < symoffset:
+      struct.pack_into('<3I2BH', image, dynsym_off + i * 16, name_offsets[i], 0, 0, 0x12, 0, 0)
+    else:
+      struct.pack_into('<3I2BH', image, dynsym_off + i * 16, name_offsets[i], export_addr[name], 4, 0x12, 0, 7)
+  image[dynstr_off:dynstr_off + len(dynstr.data)] = dynstr.data
+
+  if hash_off is not None:
+    buckets = [0] * nbucket
+    chains = [0] * len(names)
+    for i in range(1, len(names)):
+      b = sysv_hash(names[i]) % nbucket
+      chains[i] = buckets[b]
+      buckets[b] = i
+    struct.pack_into('<%dI' % (2 + nbucket + len(names)), image, hash_off, nbucket, len(names), *(buckets + chains))
+
+  if gnu_off is not None:
+    bloom_shift = 26
+    bloom = [0] * bloom_size
+    buckets = [0] * nbucket
+    chains = []
+    for i, name in enumerate(exports):
+      h = gnu_hash(name)
+      bloom[(h // 32) % bloom_size] |= (1 << (h % 32)) | (1 << ((h >> bloom_shift) % 32))
+      b = h % nbucket
+      if buckets[b] == 0:
+        buckets[b] = symoffset + i
+      last = i + 1 == len(exports) or gnu_hash(exports[i + 1]) % nbucket != b
+      chains.append((h & ~1) | (1 if last else 0))
+    struct.pack_into('<%dI' % (4 + bloom_size + nbucket + len(exports)), image, gnu_off,
+                     nbucket, symoffset, bloom_size, bloom_shift, *(bloom + buckets + chains))
+
+  # Relocations, each patching its own slot unless it shares one with an earlier relocation
+  next_slot = slots_vaddr
+  rel = bytearray()
+  plt = bytearray()
+  for kind in rel_kinds + plt_kinds:
+    if next_slot > slots_vaddr and rng.random() < shared:
+      slot = slots_vaddr + rng.randrange((next_slot - slots_vaddr) // 4) * 4
+      fresh = False
+    else:
+      slot = next_slot
+      next_slot += 4
+      fresh = True
+    if kind == 'relative' or (kind != 'relative' and not imports and not exports):
+      if fresh:
+        struct.pack_into('<I', image, slot, text_off)
+      entry = struct.pack('<2I', slot, R_ARM_RELATIVE)
+    else:
+      if kind == 'jump_slot' or (imports and rng.random() < 0.5) or not exports:
+        sym = rng.randrange(1, symoffset)
+      else:
+        sym = rng.randrange(symoffset, len(names))
+      rtype = {'abs32': R_ARM_ABS32, 'glob_dat': R_ARM_GLOB_DAT, 'jump_slot': R_ARM_JUMP_SLOT}[kind]
+      entry = struct.pack('<2I', slot, (sym << 8) | rtype)
+    if kind == 'jump_slot':
+      plt += entry
+    else:
+      rel += entry
+  image[rel_off:rel_off + len(rel)] = rel
+  image[plt_off:plt_off + len(plt)] = plt
+
+  dyn = [(DT_NEEDED, o) for o in needed_offsets]
+  dyn += [(DT_SONAME, soname_offset), (DT_STRTAB, dynstr_off), (DT_STRSZ, len(dynstr.data)),
+          (DT_SYMTAB, dynsym_off), (DT_SYMENT, 16), (DT_REL, rel_off), (DT_RELSZ, len(rel)),
+          (DT_RELENT, 8), (DT_JMPREL, plt_off), (DT_PLTRELSZ, len(plt)), (DT_PLTREL, 17)]
+  if hash_off is not None:
+    dyn.append((DT_HASH, hash_off))
+  if gnu_off is not None:
+    dyn.append((DT_GNU_HASH, gnu_off))
+  dyn.append((DT_NULL, 0))
+  assert len(dyn) <= num_dyn
+  for i, (tag, val) in enumerate(dyn):
+    struct.pack_into('<2I', image, dynamic_vaddr + i * 8, tag, val)
+
+  # ELF header and program headers
+  ident = b'\x7fELF' + bytes([1, 1, 1]) + bytes(9)
+  struct.pack_into('<16s2H5I6H', image, 0, ident, 3, 40, 1, 0, 52, 0, 0x05000000, 52, 32, num_phdr, 40, 0, 0)
+  phdrs = [
+    (1, 0, 0, 0, text_size, text_size, 5, PAGE),
+    (1, data_vaddr, data_vaddr, data_vaddr, data_size, data_size, 6, PAGE),
+    (2, dynamic_vaddr, dynamic_vaddr, dynamic_vaddr, num_dyn * 8, num_dyn * 8, 6, 4),
+  ]
+  for i, p in enumerate(phdrs):
+    struct.pack_into('<8I', image, 52 + i * 32, *p)
+
+  return bytes(image)
+
+
+def main():
+  parser = argparse.ArgumentParser(description='Generate synthetic ARM ELF32 shared objects')
+  parser.add_argument('--out', default='.', help='output directory')
+  parser.add_argument('--symbols', type=int, default=20000, help='exported functions')
+  parser.add_argument('--imports', type=int, default=1000, help='undefined symbols')
+  parser.add_argument('--relocs', type=int, default=100000, help='relocations')
+  parser.add_argument('--mix', default='70,10,10,10', help='relative,abs32,glob_dat,jump_slot weights')
+  parser.add_argument('--shared', type=float, default=0.01, help='fraction of relocations that patch an earlier slot')
+  parser.add_argument('--hash', choices=['sysv', 'gnu', 'both', 'none'], default='both')
+  parser.add_argument('--needed', type=int, default=2, help='DT_NEEDED dependencies')
+  parser.add_argument('--seed', type=int, default=1)
+  args = parser.parse_args()
+
+  rng = random.Random(args.seed)
+  mix = [float(x) for x in args.mix.split(',')]
+  imports = ['import_%d' % i for i in range(args.imports)]
+  exports = ['export_%d' % i for i in range(args.symbols)]
+  needed = ['libdep%d.so' % i for i in range(args.needed)]
+
+  os.makedirs(args.out, exist_ok=True)
+
+  for i, dep in enumerate(needed):
+    dep_exports = imports[i::len(needed)]
+    image = build(dep, dep_exports, [], [], len(dep_exports), [1, 0, 0, 0], args.hash, rng)
+    with open(os.path.join(args.out, dep), 'wb') as f:
+      f.write(image)
+
+  image = build('libbench.so', exports, imports, needed, args.relocs, mix, args.hash, rng, args.shared)
+  with open(os.path.join(args.out, 'libbench.so'), 'wb') as f:
+    f.write(image)
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,13 @@
+#version 100
+#extension GL_OES_standard_derivatives : enable
+precision mediump float;
+uniform sampler2D u_tex;
+varying vec4 v_color;
+varying vec2 v_uv;
+varying vec4 v_extra;
+void main(void)
+{
+  vec4 c = texture2D(u_tex, v_uv) * v_color;
+  if (c.a < 0.1) discard;
+  gl_FragColor = mix(c, v_extra, gl_FragCoord.x * 0.001);
+}
@@ -0,0 +1,13 @@
+#version 100
+precision mediump float;
+attribute vec4 a_position;
+attribute highp vec2 a_uv;
+uniform mat4 u_mvp;
+varying vec2 v_uv;
+varying lowp vec4 v_color, v_extra;
+void main() {
+  gl_Position = u_mvp * a_position;
+  v_uv = a_uv * 2.0 - 1.0;
+  v_color = vec4(1.0, 0.5, 0.0, 1.0);
+  v_extra = vec4(fract(v_uv.x), 0.0, 0.0, 1.0);
+}
@@ -0,0 +1,6 @@
+attribute vec2 a_position;
+attribute float a_size;
+void main() {
+  gl_PointSize = a_size;
+  gl_Position = vec4(a_position, 0.0, 1.0);
+}
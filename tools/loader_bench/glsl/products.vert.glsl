@@ -0,0 +1,20 @@
+uniform mat4 u_mvp;
+uniform mat4 u_model;
+uniform mat4 u_bones[4];
+uniform vec3 u_light;
+attribute vec3 a_position;
+attribute vec3 a_normal;
+attribute float a_bone;
+varying float v_shade;
+float half_of(float x) { return x * 0.5; }
+void main() {
+  vec4 p = vec4(a_position, 1.0) * u_mvp;
+  vec3 n = mat3(u_model) * a_normal;
+  vec3 r = a_normal * mat3(u_model) / 2.0;
+  mat4 m = 2.0 * u_model, k = u_mvp * u_model;
+  vec4 w = (u_mvp * u_model) * p;
+  w += u_bones[int(a_bone)] * -p;
+  vec4 c = k[1] * half_of(2.0) - u_model[0] * 3.0;
+  v_shade = dot(n, u_light) * half_of(r.x) + m[2].x * (w.y * 2.0) + c.z;
+  gl_Position = u_mvp * u_model * vec4(a_position, 1.0);
+}
@@ -0,0 +1,101 @@
+/* glsl_check.c -- compares glsl_translate against the expected Cg of each sample
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "glsl_translate.h"
+
+static char *read_file(const char *path, int *size) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return NULL;
+
+  fseek(file, 0, SEEK_END);
+  *size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  char *buf = malloc(*size + 1);
+  if (buf && fread(buf, 1, *size, file) == *size) {
+    buf[*size] = '\0';
+  } else {
+    free(buf);
+    buf = NULL;
+  }
+
+  fclose(file);
+  return buf;
+}
+
+// Each name.vert.glsl or name.frag.glsl is checked against name.vert.cg or name.frag.cg next to it.
+// With -u the expected files are written instead, review their diff before committing them.
+int main(int argc, char *argv[]) {
+  int update = 0, failed = 0, opt;
+
+  while ((opt = getopt(argc, argv, "u")) != -1) {
+    switch (opt) {
+      case 'u':
+        update = 1;
+        break;
+      default:
+        printf("Usage: %s [-u] sample.vert.glsl sample.frag.glsl ...\n", argv[0]);
+        return 1;
+    }
+  }
+
+  for (int i = optind; i < argc; i++) {
+    char expected_path[512];
+    int length = strlen(argv[i]), size, expected_size, out_length;
+
+    if (length < 10 || strcmp(argv[i] + length - 5, ".glsl") != 0) {
+      printf("%s: not a .glsl sample\n", argv[i]);
+      return 1;
+    }
+    snprintf(expected_path, sizeof(expected_path), "%.*s.cg", length - 5, argv[i]);
+    int fragment = strcmp(argv[i] + length - 10, ".frag.glsl") == 0;
+
+    char *source = read_file(argv[i], &size);
+    if (!source) {
+      printf("%s: could not be read\n", argv[i]);
+      return 1;
+    }
+
+    char *out = glsl_translate(source, size, fragment, &out_length);
+    free(source);
+    if (!out) {
+      printf("%s: translation failed\n", argv[i]);
+      failed++;
+      continue;
+    }
+
+    if (update) {
+      FILE *file = fopen(expected_path, "wb");
+      if (!file || fwrite(out, 1, out_length, file) != out_length) {
+        printf("%s: could not be written\n", expected_path);
+        return 1;
+      }
+      fclose(file);
+      free(out);
+      continue;
+    }
+
+    char *expected = read_file(expected_path, &expected_size);
+    if (!expected || expected_size != out_length || memcmp(expected, out, out_length) != 0) {
+      printf("%s: output differs from %s\n%s\n", argv[i], expected_path, out);
+      failed++;
+    }
+
+    free(expected);
+    free(out);
+  }
+
+  printf("%d of %d samples translated as expected\n", argc - optind - failed, argc - optind);
+  return failed ? 1 : 0;
+}
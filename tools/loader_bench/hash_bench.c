@@ -0,0 +1,79 @@
+/* hash_bench.c -- shader key throughput, SHA1 against XXH64
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <vitasdk.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sha1.h"
+#include "xxhash.h"
+
+static const int sizes[] = { 256, 1024, 4096, 16384, 65536 };
+
+static volatile uint64_t sink;
+
+static void hash_sha1(const uint8_t *buf, int size) {
+  uint32_t sha1[5];
+  SHA1_CTX ctx;
+
+  sha1_init(&ctx);
+  sha1_update(&ctx, buf, size);
+  sha1_final(&ctx, (uint8_t *)sha1);
+  sink = sha1[0];
+}
+
+static void hash_xxh64(const uint8_t *buf, int size) {
+  sink = xxh64(buf, size, 0);
+}
+
+// Returns MB/s over enough rounds to hash total bytes
+static double measure(void (* hash)(const uint8_t *, int), const uint8_t *buf, int size, int total) {
+  int rounds = total / size;
+  SceUInt64 start = sceKernelGetProcessTimeWide();
+  for (int i = 0; i < rounds; i++)
+    hash(buf + (i & 7), size); // vary the alignment like real source strings
+  SceUInt64 elapsed = sceKernelGetProcessTimeWide() - start;
+  return elapsed ? (double)rounds * size / elapsed : 0.0;
+}
+
+int main(int argc, char *argv[]) {
+  int total = 64 * 1024 * 1024, opt;
+
+  while ((opt = getopt(argc, argv, "m:")) != -1) {
+    switch (opt) {
+      case 'm':
+        total = atoi(optarg) * 1024 * 1024;
+        break;
+      default:
+        printf("Usage: %s [-m megabytes per size]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  int max_size = sizes[sizeof(sizes) / sizeof(int) - 1];
+  uint8_t *buf = malloc(max_size + 8);
+  if (!buf)
+    return 1;
+
+  // Printable text, so that the data looks like GLSL to the hashes
+  for (int i = 0; i < max_size + 8; i++)
+    buf[i] = 32 + (i * 7919 + (i >> 5)) % 95;
+
+  printf("%-8s %12s %12s %8s\n", "size", "sha1 MB/s", "xxh64 MB/s", "speedup");
+  for (int i = 0; i < sizeof(sizes) / sizeof(int); i++) {
+    double sha1 = measure(hash_sha1, buf, sizes[i], total);
+    double xxh = measure(hash_xxh64, buf, sizes[i], total);
+    printf("%-8d %12.1f %12.1f %7.1fx\n", sizes[i], sha1, xxh, sha1 > 0 ? xxh / sha1 : 0.0);
+  }
+
+  free(buf);
+  return 0;
+}
@@ -0,0 +1,51 @@
+/* shader_compiler_mock.c -- stand-in for libshacccg on the host
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <vitasdk.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "glsl_translate.h"
+#include "shader_compiler.h"
+
+#define MOCK_MAGIC "GXP\0"
+
+// Compile time per KB of source, roughly what libshacccg takes on the Vita
+int mock_compile_us_per_kb = 20000;
+
+// Sources containing this fail to compile
+const char *mock_compile_error = "#error";
+
+// The "GXP" is the magic, the stage and the source, so that callers can check what they got
+static void *mock_compile(const char *source, int length, int fragment, int *size) {
+  usleep(mock_compile_us_per_kb * (length / 1024 + 1));
+
+  if (mock_compile_error && strstr(source, mock_compile_error))
+    return NULL;
+
+  uint8_t *gxp = malloc(8 + length);
+  if (!gxp)
+    return NULL;
+
+  memcpy(gxp, MOCK_MAGIC, 4);
+  memcpy(gxp + 4, &fragment, 4);
+  memcpy(gxp + 8, source, length);
+  *size = 8 + length;
+  return gxp;
+}
+
+// Translates like the libshacccg backend, so that the bench runs the same path
+shader_compiler shader_compiler_mock = {
+  "mock",
+  NULL,
+  glsl_translate,
+  mock_compile,
+  NULL,
+};
@@ -0,0 +1,211 @@
+/* shim.c -- POSIX implementation of the Vita APIs used by the loader
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#include <vitasdk.h>
+#include <kubridge.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHIM_MAX_BLOCKS 64
+#define SHIM_MAX_THREADS 16
+#define SHIM_MAX_DIRS 8
+
+typedef struct {
+  void *base;
+  size_t size;
+} shim_block;
+
+typedef struct {
+  pthread_t thread;
+  SceKernelThreadEntry entry;
+  void *argp;
+  SceSize args;
+  int used;
+} shim_thread;
+
+static shim_block blocks[SHIM_MAX_BLOCKS];
+static shim_thread threads[SHIM_MAX_THREADS];
+static DIR *dirs[SHIM_MAX_DIRS];
+
+void fatal_error(const char *fmt, ...) {
+  va_list list;
+  va_start(list, fmt);
+  vfprintf(stderr, fmt, list);
+  va_end(list);
+  fprintf(stderr, "\n");
+  exit(1);
+}
+
+int debugPrintf(char *text, ...) {
+  return 0;
+}
+
+SceUID sceIoOpen(const char *file, int flags, SceMode mode) {
+  int oflags = (flags & SCE_O_RDWR) == SCE_O_RDWR ? O_RDWR : (flags & SCE_O_WRONLY) ? O_WRONLY : O_RDONLY;
+  if (flags & SCE_O_APPEND)
+    oflags |= O_APPEND;
+  if (flags & SCE_O_CREAT)
+    oflags |= O_CREAT;
+  if (flags & SCE_O_TRUNC)
+    oflags |= O_TRUNC;
+  return open(file, oflags, mode);
+}
+
+int sceIoClose(SceUID fd) {
+  return close(fd);
+}
+
+int sceIoRead(SceUID fd, void *data, SceSize size) {
+  return read(fd, data, size);
+}
+
+int sceIoWrite(SceUID fd, const void *data, SceSize size) {
+  return write(fd, data, size);
+}
+
+SceOff sceIoLseek(SceUID fd, SceOff offset, int whence) {
+  return lseek(fd, offset, whence);
+}
+
+int sceIoRemove(const char *file) {
+  return unlink(file);
+}
+
+int sceIoRename(const char *oldname, const char *newname) {
+  return rename(oldname, newname);
+}
+
+int sceIoMkdir(const char *dir, SceMode mode) {
+  return mkdir(dir, mode);
+}
+
+SceUID sceIoDopen(const char *dirname) {
+  for (int i = 0; i < SHIM_MAX_DIRS; i++) {
+    if (!dirs[i]) {
+      dirs[i] = opendir(dirname);
+      return dirs[i] ? i : -1;
+    }
+  }
+  return -1;
+}
+
+int sceIoDread(SceUID fd, SceIoDirent *dir) {
+  struct dirent *entry = readdir(dirs[fd]);
+  if (!entry)
+    return 0;
+  memset(dir, 0, sizeof(SceIoDirent));
+  snprintf(dir->d_name, sizeof(dir->d_name), "%s", entry->d_name);
+
+  struct stat st;
+  if (fstatat(dirfd(dirs[fd]), entry->d_name, &st, 0) == 0)
+    dir->d_stat.st_size = st.st_size;
+  return 1;
+}
+
+int sceIoDclose(SceUID fd) {
+  closedir(dirs[fd]);
+  dirs[fd] = NULL;
+  return 0;
+}
+
+// ELF32 slots only hold 32-bit addresses, so blocks are mapped exactly where the loader asks
+SceUID kuKernelAllocMemBlock(const char *name, SceUInt32 type, SceSize size, SceKernelAllocMemBlockKernelOpt *opt) {
+  void *hint = (opt && (opt->attr & 0x1)) ? (void *)(uintptr_t)opt->field_C : NULL;
+
+  for (int i = 1; i < SHIM_MAX_BLOCKS; i++) {
+    if (blocks[i].base)
+      continue;
+
+    void *base = mmap(hint, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | (hint ? MAP_FIXED_NOREPLACE : 0), -1, 0);
+    if (base == MAP_FAILED)
+      return -1;
+
+    blocks[i].base = base;
+    blocks[i].size = size;
+    return i;
+  }
+
+  return -1;
+}
+
+int sceKernelGetMemBlockBase(SceUID uid, void **base) {
+  *base = blocks[uid].base;
+  return 0;
+}
+
+int sceKernelFreeMemBlock(SceUID uid) {
+  if (uid <= 0 || uid >= SHIM_MAX_BLOCKS || !blocks[uid].base)
+    return -1;
+  munmap(blocks[uid].base, blocks[uid].size);
+  blocks[uid].base = NULL;
+  return 0;
+}
+
+int kuKernelCpuUnrestrictedMemcpy(void *dst, const void *src, SceSize len) {
+  memcpy(dst, src, len);
+  return 0;
+}
+
+void kuKernelFlushCaches(const void *ptr, SceSize len) {
+}
+
+static void *shim_thread_entry(void *arg) {
+  shim_thread *thread = (shim_thread *)arg;
+  return (void *)(intptr_t)thread->entry(thread->args, thread->argp);
+}
+
+SceUID sceKernelCreateThread(const char *name, SceKernelThreadEntry entry, int priority, SceSize stack_size, SceUInt32 attr, int cpu_affinity_mask, const void *option) {
+  for (int i = 1; i < SHIM_MAX_THREADS; i++) {
+    if (!threads[i].used) {
+      threads[i].used = 1;
+      threads[i].entry = entry;
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Like the kernel, the arguments are copied for the new thread
+int sceKernelStartThread(SceUID thid, SceSize arglen, void *argp) {
+  shim_thread *thread = &threads[thid];
+  thread->args = arglen;
+  thread->argp = malloc(arglen);
+  memcpy(thread->argp, argp, arglen);
+  return pthread_create(&thread->thread, NULL, shim_thread_entry, thread);
+}
+
+int sceKernelWaitThreadEnd(SceUID thid, int *stat, SceUInt32 *timeout) {
+  void *res;
+  pthread_join(threads[thid].thread, &res);
+  if (stat)
+    *stat = (int)(intptr_t)res;
+  return 0;
+}
+
+int sceKernelDeleteThread(SceUID thid) {
+  free(threads[thid].argp);
+  memset(&threads[thid], 0, sizeof(shim_thread));
+  return 0;
+}
+
+SceUInt64 sceKernelGetProcessTimeWide(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (SceUInt64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -0,0 +1,25 @@
+/* kubridge.h -- host stand-in for kubridge
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef __KUBRIDGE_SHIM_H__
+#define __KUBRIDGE_SHIM_H__
+
+#include <vitasdk.h>
+
+typedef struct {
+  SceSize size;
+  SceUInt32 data_04;
+  SceUInt32 attr;
+  SceUInt32 field_C;
+} SceKernelAllocMemBlockKernelOpt;
+
+SceUID kuKernelAllocMemBlock(const char *name, SceUInt32 type, SceSize size, SceKernelAllocMemBlockKernelOpt *opt);
+int kuKernelCpuUnrestrictedMemcpy(void *dst, const void *src, SceSize len);
+void kuKernelFlushCaches(const void *ptr, SceSize len);
+
+#endif
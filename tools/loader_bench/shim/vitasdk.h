@@ -0,0 +1,74 @@
+/* vitasdk.h -- host stand-in for the parts of the SDK that the loader uses
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#ifndef __VITASDK_SHIM_H__
+#define __VITASDK_SHIM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int SceUID;
+typedef int SceMode;
+typedef unsigned int SceSize;
+typedef unsigned int SceUInt32;
+typedef long long SceOff;
+typedef unsigned long long SceUInt64;
+
+typedef int (* SceKernelThreadEntry)(SceSize args, void *argp);
+
+typedef struct {
+  int unused;
+} SceTouchPanelInfo;
+
+typedef struct {
+  SceMode st_mode;
+  unsigned int st_attr;
+  SceOff st_size;
+} SceIoStat;
+
+typedef struct {
+  SceIoStat d_stat;
+  char d_name[256];
+} SceIoDirent;
+
+#define SCE_O_RDONLY 0x0001
+#define SCE_O_WRONLY 0x0002
+#define SCE_O_RDWR   0x0003
+#define SCE_O_APPEND 0x0100
+#define SCE_O_CREAT  0x0200
+#define SCE_O_TRUNC  0x0400
+
+#define SCE_SEEK_SET 0
+#define SCE_SEEK_CUR 1
+#define SCE_SEEK_END 2
+
+#define SCE_KERNEL_MEMBLOCK_TYPE_USER_RW 0x0c20d060
+
+SceUID sceIoOpen(const char *file, int flags, SceMode mode);
+int sceIoClose(SceUID fd);
+int sceIoRead(SceUID fd, void *data, SceSize size);
+int sceIoWrite(SceUID fd, const void *data, SceSize size);
+SceOff sceIoLseek(SceUID fd, SceOff offset, int whence);
+int sceIoRemove(const char *file);
+int sceIoRename(const char *oldname, const char *newname);
+int sceIoMkdir(const char *dir, SceMode mode);
+SceUID sceIoDopen(const char *dirname);
+int sceIoDread(SceUID fd, SceIoDirent *dir);
+int sceIoDclose(SceUID fd);
+
+int sceKernelGetMemBlockBase(SceUID uid, void **base);
+int sceKernelFreeMemBlock(SceUID uid);
+
+SceUID sceKernelCreateThread(const char *name, SceKernelThreadEntry entry, int priority, SceSize stack_size, SceUInt32 attr, int cpu_affinity_mask, const void *option);
+int sceKernelStartThread(SceUID thid, SceSize arglen, void *argp);
+int sceKernelWaitThreadEnd(SceUID thid, int *stat, SceUInt32 *timeout);
+int sceKernelDeleteThread(SceUID thid);
+
+SceUInt64 sceKernelGetProcessTimeWide(void);
+
+#endif
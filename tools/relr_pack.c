@@ -0,0 +1,227 @@
+/* relr_pack.c -- pack relative relocations into a sidecar for the loader
+ *
+ * Copyright (C) 2023 Andy Nguyen
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ *
+ * Host tool, build with:
+ *   gcc -O2 -o relr_pack tools/relr_pack.c loader/xxhash.c -iquote loader
+ */
+
+#include <elf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xxhash.h"
+
+// Must match so_relr_header in loader/so_util.c
+#define SO_RELR_MAGIC 0x524C4552 // RELR
+#define SO_RELR_VERSION 3
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t so_digest;
+  uint32_t num_relr;
+  uint32_t num_reldyn;
+} so_relr_header;
+
+static uint8_t *image;
+static size_t image_size;
+
+static Elf32_Ehdr *ehdr;
+static Elf32_Phdr *phdr;
+
+static void *vaddr_to_file(uint32_t vaddr, size_t size) {
+  for (int i = 0; i < ehdr->e_phnum; i++) {
+    if (phdr[i].p_type != PT_LOAD)
+      continue;
+    if (vaddr >= phdr[i].p_vaddr && vaddr + size <= phdr[i].p_vaddr + phdr[i].p_filesz)
+      return image + phdr[i].p_offset + (vaddr - phdr[i].p_vaddr);
+  }
+  return NULL;
+}
+
+// Same digest as so_load computes, so the loader can tell that the sidecar belongs to its image
+static uint64_t image_digest(void) {
+  XXH64_CTX ctx;
+  xxh64_init(&ctx, 0);
+  xxh64_update(&ctx, ehdr, sizeof(Elf32_Ehdr));
+  xxh64_update(&ctx, phdr, ehdr->e_phnum * sizeof(Elf32_Phdr));
+  for (int i = 0; i < ehdr->e_phnum; i++) {
+    if (phdr[i].p_type == PT_LOAD)
+      xxh64_update(&ctx, image + phdr[i].p_offset, phdr[i].p_filesz);
+  }
+  return xxh64_final(&ctx);
+}
+
+static int compare_u32(const void *a, const void *b) {
+  uint32_t ua = *(const uint32_t *)a;
+  uint32_t ub = *(const uint32_t *)b;
+  return (ua > ub) - (ua < ub);
+}
+
+static int slot_count(const uint32_t *slots, int num, uint32_t offset) {
+  int lo = 0, hi = num;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (slots[mid] < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  int count = 0;
+  while (lo + count < num && slots[lo + count] == offset)
+    count++;
+  return count;
+}
+
+// Address words are even, bitmap words are odd and cover the 31 words after the previous base
+static int relr_encode(const uint32_t *offsets, int num, uint32_t *out) {
+  int num_out = 0;
+  int i = 0;
+
+  while (i < num) {
+    uint32_t base = offsets[i++];
+    out[num_out++] = base;
+    base += sizeof(uint32_t);
+
+    while (1) {
+      uint32_t bitmap = 0;
+      while (i < num && offsets[i] - base < 31 * sizeof(uint32_t)) {
+        bitmap |= 1 << ((offsets[i] - base) / sizeof(uint32_t));
+        i++;
+      }
+      if (!bitmap)
+        break;
+      out[num_out++] = (bitmap << 1) | 1;
+      base += 31 * sizeof(uint32_t);
+    }
+  }
+
+  return num_out;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    printf("Usage: %s libTheConduit.so libTheConduit.relr\n", argv[0]);
+    return 1;
+  }
+
+  FILE *file = fopen(argv[1], "rb");
+  if (!file) {
+    printf("Error could not open %s\n", argv[1]);
+    return 1;
+  }
+
+  fseek(file, 0, SEEK_END);
+  image_size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  image = malloc(image_size);
+  if (!image || fread(image, 1, image_size, file) != image_size) {
+    printf("Error could not read %s\n", argv[1]);
+    return 1;
+  }
+  fclose(file);
+
+  ehdr = (Elf32_Ehdr *)image;
+  if (image_size < sizeof(Elf32_Ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+      ehdr->e_ident[EI_CLASS] != ELFCLASS32 || ehdr->e_machine != EM_ARM) {
+    printf("Error %s is not an ARM ELF32 image\n", argv[1]);
+    return 1;
+  }
+  phdr = (Elf32_Phdr *)(image + ehdr->e_phoff);
+
+  Elf32_Dyn *dynamic = NULL;
+  int num_dynamic = 0;
+  for (int i = 0; i < ehdr->e_phnum; i++) {
+    if (phdr[i].p_type == PT_DYNAMIC) {
+      dynamic = (Elf32_Dyn *)(image + phdr[i].p_offset);
+      num_dynamic = phdr[i].p_filesz / sizeof(Elf32_Dyn);
+    }
+  }
+
+  uint32_t rel = 0, relsz = 0, jmprel = 0, pltrelsz = 0;
+  for (int i = 0; i < num_dynamic && dynamic[i].d_tag != DT_NULL; i++) {
+    if (dynamic[i].d_tag == DT_REL)
+      rel = dynamic[i].d_un.d_ptr;
+    else if (dynamic[i].d_tag == DT_RELSZ)
+      relsz = dynamic[i].d_un.d_val;
+    else if (dynamic[i].d_tag == DT_JMPREL)
+      jmprel = dynamic[i].d_un.d_ptr;
+    else if (dynamic[i].d_tag == DT_PLTRELSZ)
+      pltrelsz = dynamic[i].d_un.d_val;
+    else if (dynamic[i].d_tag == 36 || dynamic[i].d_tag == 0x6fffe000) {
+      printf("Error %s already has packed relocations\n", argv[1]);
+      return 1;
+    }
+  }
+
+  Elf32_Rel *reldyn = vaddr_to_file(rel, relsz);
+  if (!reldyn) {
+    printf("Error %s has no .rel.dyn\n", argv[1]);
+    return 1;
+  }
+
+  Elf32_Rel *relplt = vaddr_to_file(jmprel, pltrelsz);
+  int num_reldyn = relsz / sizeof(Elf32_Rel);
+  int num_relplt = relplt ? pltrelsz / sizeof(Elf32_Rel) : 0;
+
+  // Every slot that any relocation patches, to find the ones that are patched more than once
+  uint32_t *slots = malloc((num_reldyn + num_relplt) * sizeof(uint32_t));
+  for (int i = 0; i < num_reldyn; i++)
+    slots[i] = reldyn[i].r_offset;
+  for (int i = 0; i < num_relplt; i++)
+    slots[num_reldyn + i] = relplt[i].r_offset;
+  qsort(slots, num_reldyn + num_relplt, sizeof(uint32_t), compare_u32);
+
+  uint32_t *offsets = malloc(num_reldyn * sizeof(uint32_t));
+  Elf32_Rel *others = malloc(num_reldyn * sizeof(Elf32_Rel));
+  uint32_t *relr = malloc(num_reldyn * sizeof(uint32_t));
+  int num_offsets = 0, num_others = 0, num_relative = 0;
+
+  // RELR is applied before .rel.dyn, so only slots that no other relocation touches can move there.
+  // Shared slots, duplicates included, stay in .rel.dyn and keep their order.
+  for (int i = 0; i < num_reldyn; i++) {
+    num_relative += ELF32_R_TYPE(reldyn[i].r_info) == R_ARM_RELATIVE;
+    if (ELF32_R_TYPE(reldyn[i].r_info) == R_ARM_RELATIVE && (reldyn[i].r_offset & 3) == 0 &&
+        slot_count(slots, num_reldyn + num_relplt, reldyn[i].r_offset) == 1)
+      offsets[num_offsets++] = reldyn[i].r_offset;
+    else
+      others[num_others++] = reldyn[i];
+  }
+
+  qsort(offsets, num_offsets, sizeof(uint32_t), compare_u32);
+
+  int num_relr = relr_encode(offsets, num_offsets, relr);
+
+  so_relr_header hdr;
+  memset(&hdr, 0, sizeof(so_relr_header));
+  hdr.magic = SO_RELR_MAGIC;
+  hdr.version = SO_RELR_VERSION;
+  hdr.so_digest = image_digest();
+  hdr.num_relr = num_relr;
+  hdr.num_reldyn = num_others;
+
+  file = fopen(argv[2], "wb");
+  if (!file) {
+    printf("Error could not open %s\n", argv[2]);
+    return 1;
+  }
+  fwrite(&hdr, 1, sizeof(so_relr_header), file);
+  fwrite(relr, sizeof(uint32_t), num_relr, file);
+  fwrite(others, sizeof(Elf32_Rel), num_others, file);
+  fclose(file);
+
+  // The gain is in what boot reads and walks, relocating the packed slots costs about the same
+  printf("%d of %d relative relocations packed, %d relocations kept\n",
+         num_offsets, num_relative, num_others);
+  printf(".rel.dyn %u bytes -> sidecar %u bytes\n", (unsigned int)relsz,
+         (unsigned int)(sizeof(so_relr_header) + num_relr * sizeof(uint32_t) + num_others * sizeof(Elf32_Rel)));
+
+  return 0;
+}
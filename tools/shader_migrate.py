@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+# shader_migrate.py -- move shaders.psarc and the glsl dumps to XXH64 keys
+#
+# Copyright (C) 2023 Andy Nguyen
+#
+# This software may be modified and distributed under the terms
+# of the MIT license.  See the LICENSE file for details.
+#
+# Usage: tools/shader_migrate.py [--psarc in.psarc --out out.psarc] [--glsl dir] [--sources dir...]
+#
+# Shaders used to be named after the first word of the SHA1 of their source,
+# <8 hex digits>.cg.gxp. They are now named <XXH64 of the source>_<source
+# length>.cg.gxp, see glShaderSourceHook. A compiled shader can only be renamed
+# if its source is known, so every file in the glsl dump directory and in the
+# extra source directories is hashed both ways. Dumps in the glsl directory
+# are renamed in place. The dummy shaders and shaders without a known source
+# keep their legacy names, which the loader still finds through the SHA1 word
+# when the XXH64 key misses.
+
+import argparse
+import hashlib
+import os
+import re
+import struct
+import sys
+import zlib
+
+from xxh64 import xxh64
+
+DUMMY_SHADERS = (0xbf999cdf, 0x0539a408)
+
+PSARC_BLOCK_SIZE = 0x10000
+PSARC_ENTRY_SIZE = 30
+
+LEGACY_NAME = re.compile(r'^(.*/)?([0-9a-f]{8})\.cg\.gxp$')
+LEGACY_DUMP = re.compile(r'^([0-9a-f]{8})\.glsl$')
+
+
+def legacy_key(source):
+  # glShaderSourceHook printed the first digest word as a little endian uint32_t
+  return struct.unpack_from('<I', hashlib.sha1(source).digest())[0]
+
+
+def new_name(source):
+  return '%016x_%08x' % (xxh64(source), len(source))
+
+
+class Psarc:
+  def __init__(self, path):
+    with open(path, 'rb') as f:
+      self.data = f.read()
+
+    magic, major, minor, compression, toc_size, entry_size, num_entries, block_size, flags = \
+      struct.unpack_from('>4sHH4sIIIII', self.data, 0)
+    if magic != b'PSAR':
+      sys.exit('Error %s is not a PSARC' % path)
+    if compression != b'zlib' and compression != b'\0\0\0\0':
+      sys.exit('Error %s uses unsupported compression %r' % (path, compression))
+
+    self.version = (major, minor)
+    self.block_size = block_size
+    self.flags = flags
+
+    width = 2 if block_size <= 0x10000 else (3 if block_size <= 0x1000000 else 4)
+    table = 32 + num_entries * entry_size
+    self.blocks = [int.from_bytes(self.data[i:i + width], 'big') for i in range(table, toc_size, width)]
+
+    entries = []
+    for i in range(num_entries):
+      e = 32 + i * entry_size
+      block, = struct.unpack_from('>I', self.data, e + 16)
+      size = int.from_bytes(self.data[e + 20:e + 25], 'big')
+      offset = int.from_bytes(self.data[e + 25:e + 30], 'big')
+      entries.append((block, size, offset))
+
+    names = self.extract(entries[0]).decode().split('\n')
+    self.files = [(names[i - 1].rstrip('\r'), self.extract(entries[i])) for i in range(1, num_entries)]
+
+  def extract(self, entry):
+    block, size, offset = entry
+    out = bytearray()
+    while len(out) < size:
+      want = min(self.block_size, size - len(out))
+      have = self.blocks[block] or self.block_size
+      chunk = self.data[offset:offset + have]
+      out += chunk if have == want else zlib.decompress(chunk)
+      offset += have
+      block += 1
+    return bytes(out)
+
+
+def write_psarc(path, files, flags, version):
+  def md5(name):
+    return hashlib.md5((name.upper() if flags & 1 else name).encode()).digest()
+
+  manifest = '\n'.join(name for name, _ in files).encode()
+  contents = [(b'\0' * 16, manifest)] + [(md5(name), data) for name, data in files]
+
+  blocks, body, entries = [], bytearray(), []
+  for digest, data in contents:
+    entries.append((digest, len(blocks), len(data), len(body)))
+    for i in range(0, len(data), PSARC_BLOCK_SIZE):
+      chunk = data[i:i + PSARC_BLOCK_SIZE]
+      packed = zlib.compress(chunk, 9)
+      if len(packed) >= len(chunk):
+        packed = chunk
+      blocks.append(0 if len(packed) == PSARC_BLOCK_SIZE else len(packed))
+      body += packed
+
+  toc_size = 32 + len(entries) * PSARC_ENTRY_SIZE + len(blocks) * 2
+  out = bytearray(struct.pack('>4sHH4sIIIII', b'PSAR', version[0], version[1], b'zlib', toc_size,
+                              PSARC_ENTRY_SIZE, len(entries), PSARC_BLOCK_SIZE, flags))
+  for digest, block, size, offset in entries:
+    out += digest + struct.pack('>I', block) + size.to_bytes(5, 'big') + (toc_size + offset).to_bytes(5, 'big')
+  for size in blocks:
+    out += struct.pack('>H', size)
+  out += body
+
+  with open(path, 'wb') as f:
+    f.write(out)
+
+
+def collect_sources(dirs):
+  sources = {}
+  for d in dirs:
+    for name in sorted(os.listdir(d)):
+      path = os.path.join(d, name)
+      if not os.path.isfile(path):
+        continue
+      with open(path, 'rb') as f:
+        source = f.read()
+      sources.setdefault(legacy_key(source), source)
+  return sources
+
+
+def main():
+  parser = argparse.ArgumentParser(description='Rename shaders from SHA1 prefixes to XXH64 keys')
+  parser.add_argument('--psarc', help='shaders.psarc with legacy names')
+  parser.add_argument('--out', help='migrated shaders.psarc')
+  parser.add_argument('--glsl', help='glsl dump directory, renamed in place')
+  parser.add_argument('--sources', nargs='*', default=[], help='more directories of shader sources')
+  parser.add_argument('--dry-run', action='store_true')
+  args = parser.parse_args()
+
+  if bool(args.psarc) != bool(args.out):
+    parser.error('--psarc and --out go together')
+
+  sources = collect_sources(([args.glsl] if args.glsl else []) + args.sources)
+  print('%d shader sources' % len(sources))
+
+  if args.psarc:
+    archive = Psarc(args.psarc)
+    files, renamed, kept = [], 0, 0
+    for name, data in archive.files:
+      match = LEGACY_NAME.match(name)
+      if match and int(match.group(2), 16) not in DUMMY_SHADERS:
+        key = int(match.group(2), 16)
+        if key in sources:
+          files.append(('%s%s.cg.gxp' % (match.group(1) or '', new_name(sources[key])), data))
+          renamed += 1
+          continue
+        kept += 1
+      files.append((name, data))
+
+    print('%s: %d shaders renamed, %d kept under their legacy name, %d other files' %
+          (args.out, renamed, kept, len(files) - renamed - kept))
+
+    if not args.dry_run:
+      write_psarc(args.out, files, archive.flags, archive.version)
+      check = Psarc(args.out)
+      if check.files != files:
+        sys.exit('Error %s does not read back' % args.out)
+
+  if args.glsl:
+    moved = 0
+    for name in sorted(os.listdir(args.glsl)):
+      if not LEGACY_DUMP.match(name):
+        continue
+      path = os.path.join(args.glsl, name)
+      with open(path, 'rb') as f:
+        source = f.read()
+      if not args.dry_run:
+        os.rename(path, os.path.join(args.glsl, new_name(source) + '.glsl'))
+      moved += 1
+    print('%s: %d dumps renamed' % (args.glsl, moved))
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,80 @@
+# xxh64.py -- XXH64 for the host tools, matches loader/xxhash.c
+#
+# Copyright (C) 2023 Andy Nguyen
+#
+# This software may be modified and distributed under the terms
+# of the MIT license.  See the LICENSE file for details.
+
+import struct
+
+MASK64 = (1 << 64) - 1
+PRIME64_1 = 0x9E3779B185EBCA87
+PRIME64_2 = 0xC2B2AE3D27D4EB4F
+PRIME64_3 = 0x165667B19E3779F9
+PRIME64_4 = 0x85EBCA77C2B2AE63
+PRIME64_5 = 0x27D4EB2F165667C5
+
+
+def rotl64(x, r):
+  return ((x << r) | (x >> (64 - r))) & MASK64
+
+
+def xxh64_round(acc, lane):
+  acc = (acc + lane * PRIME64_2) & MASK64
+  return (rotl64(acc, 31) * PRIME64_1) & MASK64
+
+
+def xxh64_merge(acc, val):
+  acc ^= xxh64_round(0, val)
+  return (acc * PRIME64_1 + PRIME64_4) & MASK64
+
+
+def xxh64_py(data, seed=0):
+  length = len(data)
+  p = 0
+  if length >= 32:
+    v = [(seed + PRIME64_1 + PRIME64_2) & MASK64, (seed + PRIME64_2) & MASK64,
+         seed, (seed - PRIME64_1) & MASK64]
+    while p + 32 <= length:
+      lanes = struct.unpack_from('<4Q', data, p)
+      v = [xxh64_round(v[i], lanes[i]) for i in range(4)]
+      p += 32
+    h = (rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18)) & MASK64
+    for lane in v:
+      h = xxh64_merge(h, lane)
+  else:
+    h = (seed + PRIME64_5) & MASK64
+
+  h = (h + length) & MASK64
+
+  while p + 8 <= length:
+    h ^= xxh64_round(0, struct.unpack_from('<Q', data, p)[0])
+    h = (rotl64(h, 27) * PRIME64_1 + PRIME64_4) & MASK64
+    p += 8
+
+  if p + 4 <= length:
+    h ^= (struct.unpack_from('<I', data, p)[0] * PRIME64_1) & MASK64
+    h = (rotl64(h, 23) * PRIME64_2 + PRIME64_3) & MASK64
+    p += 4
+
+  while p < length:
+    h ^= (data[p] * PRIME64_5) & MASK64
+    h = (rotl64(h, 11) * PRIME64_1) & MASK64
+    p += 1
+
+  h ^= h >> 33
+  h = (h * PRIME64_2) & MASK64
+  h ^= h >> 29
+  h = (h * PRIME64_3) & MASK64
+  h ^= h >> 32
+  return h
+
+
+try:
+  # Whole libraries are hashed by gen_hook_offsets.py, use the C module when it is installed
+  import xxhash
+
+  def xxh64(data, seed=0):
+    return xxhash.xxh64_intdigest(data, seed)
+except ImportError:
+  xxh64 = xxh64_py